@@ -0,0 +1,88 @@
+#include "scanner.h"
+#include "simd.h"
+#include <chrono>
+#include <iomanip>
+#include <iostream>
+#include <string>
+
+// 扫描器在生成的大源码上的吞吐量，分别使用逐字节、SSE2和AVX2的批量查找
+// code是缩进和短注释为主的普通代码，comments和strings分别以长注释和长字符串为主
+
+constexpr std::size_t SOURCE_SIZE = 16 << 20;
+constexpr int ROUNDS = 5;
+
+std::string generate(const std::string &unit) {
+  std::string source;
+  source.reserve(SOURCE_SIZE + unit.size());
+  for (int i = 0; source.size() < SOURCE_SIZE; i++) {
+    source += "// item " + std::to_string(i) + "\n" + unit;
+  }
+  return source;
+}
+
+std::string codeUnit() {
+  return "class Point {\n"
+         "    init(x, y) {\n"
+         "        this.x = x; // x坐标\n"
+         "        this.y = y;\n"
+         "    }\n"
+         "\n"
+         "    length() {\n"
+         "        return this.x * this.x + this.y * this.y;\n"
+         "    }\n"
+         "}\n"
+         "\n"
+         "fun walk(count) {\n"
+         "    var total = 0;\n"
+         "    for (var i = 0; i < count; i = i + 1) {\n"
+         "        total = total + Point(i, i + 1).length();\n"
+         "    }\n"
+         "    return total;\n"
+         "}\n"
+         "\n";
+}
+
+std::string commentsUnit() {
+  std::string unit = "/*\n";
+  for (int i = 0; i < 8; i++) {
+    unit += " * Walks every point in the grid and accumulates the squared length of each one.\n";
+  }
+  unit += " */\n";
+  for (int i = 0; i < 4; i++) {
+    unit += "        // the total is kept as a plain number, so very large grids lose precision here\n";
+  }
+  return unit + "var total = 0;\n\n";
+}
+
+std::string stringsUnit() {
+  std::string text(200, 'x');
+  return "var message = \"" + text + "\";\n" + "print 'first line\nsecond line\nthird line " + text + "';\n\n";
+}
+
+void run(const std::string &name, const std::string &source) {
+  Scanner &scanner = Scanner::getInstance();
+  for (simd::Level level : {simd::Level::SCALAR, simd::Level::SSE2, simd::Level::AVX2}) {
+    if (simd::setLevel(level) != level) {
+      continue;
+    }
+    std::size_t tokens = scanner.scanTokens(source).size();
+
+    auto start = std::chrono::steady_clock::now();
+    for (int round = 0; round < ROUNDS; round++) {
+      tokens = scanner.scanTokens(source).size();
+    }
+    auto end = std::chrono::steady_clock::now();
+    double seconds = std::chrono::duration<double>(end - start).count();
+
+    std::cout << std::left << std::setw(10) << name << std::setw(8) << simd::levelName(level) << std::right
+              << std::setw(10) << tokens << " tokens" << std::fixed << std::setprecision(1) << std::setw(10)
+              << static_cast<double>(source.size()) * ROUNDS / seconds / (1 << 20) << " MB/s" << std::endl;
+  }
+}
+
+int main() {
+  run("code", generate(codeUnit()));
+  run("comments", generate(commentsUnit()));
+  run("strings", generate(stringsUnit()));
+  return 0;
+}
@@ -0,0 +1,81 @@
+#include "value.h"
+#include <chrono>
+#include <iomanip>
+#include <iostream>
+#include <map>
+#include <string>
+#include <vector>
+
+// 对比TaggedValue和NanBoxedValue两种布局：
+// 数值读写、带引用计数的对象拷贝，以及Environment/Instance字段所用的map节点内存占用
+
+constexpr int COUNT = 1 << 20;
+constexpr int ROUNDS = 20;
+
+template <typename F> double measure(F &&f) {
+  auto start = std::chrono::steady_clock::now();
+  f();
+  auto end = std::chrono::steady_clock::now();
+  return std::chrono::duration<double, std::nano>(end - start).count();
+}
+
+template <typename V> void run(const std::string &name) {
+  std::vector<V> values(COUNT);
+
+  double fillNs = measure([&values]() {
+    for (int round = 0; round < ROUNDS; round++) {
+      for (int i = 0; i < COUNT; i++) {
+        values[i] = static_cast<double>(i + round);
+      }
+    }
+  });
+
+  double sum = 0;
+  double sumNs = measure([&values, &sum]() {
+    for (int round = 0; round < ROUNDS; round++) {
+      for (auto &value : values) {
+        if (value.isNumber()) {
+          sum += value.asNumber();
+        }
+      }
+    }
+  });
+
+  V string = "shared";
+  for (int i = 0; i < COUNT; i += 2) {
+    values[i] = string;
+  }
+
+  std::size_t strings = 0;
+  double copyNs = measure([&values, &strings]() {
+    for (int round = 0; round < ROUNDS; round++) {
+      std::vector<V> copy = values;
+      strings += copy.back().isString() ? 1 : 0;
+    }
+  });
+
+  std::map<std::string, V> fields;
+  double mapNs = measure([&fields]() {
+    for (int i = 0; i < COUNT; i++) {
+      fields["field" + std::to_string(i % 4096)] = static_cast<double>(i);
+    }
+  });
+
+  double total = static_cast<double>(COUNT) * ROUNDS;
+  std::cout << std::left << std::setw(14) << name << std::right << std::setw(8) << sizeof(V) << std::setw(12)
+            << (sizeof(V) * COUNT) / 1024 << std::setw(12) << sizeof(typename std::map<std::string, V>::value_type)
+            << std::fixed << std::setprecision(3) << std::setw(12) << fillNs / total << std::setw(12) << sumNs / total
+            << std::setw(12) << copyNs / total << std::setw(12) << mapNs / COUNT << "   checksum " << sum + strings
+            << std::endl;
+}
+
+int main() {
+  std::cout << std::left << std::setw(14) << "layout" << std::right << std::setw(8) << "bytes" << std::setw(12)
+            << "vector KiB" << std::setw(12) << "map entry" << std::setw(12) << "fill ns" << std::setw(12) << "sum ns"
+            << std::setw(12) << "copy ns" << std::setw(12) << "map ns" << std::endl;
+
+  run<TaggedValue>("tagged");
+  run<NanBoxedValue>("nan-boxed");
+
+  return 0;
+}
@@ -0,0 +1,30 @@
+#include "arena.h"
+#include <algorithm>
+#include <cstdint>
+
+Arena::~Arena() {
+  // 按分配的逆序析构，和普通对象的生命周期保持一致
+  for (auto it = destructors.rbegin(); it != destructors.rend(); it++) {
+    it->destroy(it->object);
+  }
+}
+
+void *Arena::allocate(std::size_t size, std::size_t align) {
+  auto address = reinterpret_cast<std::uintptr_t>(cursor);
+  std::size_t padding = (align - address % align) % align;
+
+  if (!cursor || padding + size > static_cast<std::size_t>(limit - cursor)) {
+    std::size_t blockSize = std::max(BLOCK_SIZE, size + align);
+    blocks.push_back(std::make_unique<char[]>(blockSize));
+    cursor = blocks.back().get();
+    limit = cursor + blockSize;
+
+    address = reinterpret_cast<std::uintptr_t>(cursor);
+    padding = (align - address % align) % align;
+  }
+
+  char *memory = cursor + padding;
+  cursor = memory + size;
+  bytes += padding + size;
+  return memory;
+}
@@ -0,0 +1,49 @@
+#ifndef CLOX_ARENA_H
+#define CLOX_ARENA_H
+
+#include <cstddef>
+#include <memory>
+#include <type_traits>
+#include <utility>
+#include <vector>
+
+// 按块线性分配的内存池，对象随Arena一起销毁，不支持单独释放
+class Arena {
+private:
+  static constexpr std::size_t BLOCK_SIZE = 64 * 1024;
+
+  struct Destructor {
+    void *object;
+    void (*destroy)(void *);
+  };
+
+  std::vector<std::unique_ptr<char[]>> blocks;
+  char *cursor = nullptr;
+  char *limit = nullptr;
+  std::size_t bytes = 0;
+
+  std::vector<Destructor> destructors;
+
+  void *allocate(std::size_t size, std::size_t align);
+
+public:
+  Arena() = default;
+  ~Arena();
+  Arena(const Arena &) = delete;
+  Arena &operator=(const Arena &) = delete;
+
+  template <typename T, typename... Args> T *make(Args &&...args) {
+    void *memory = allocate(sizeof(T), alignof(T));
+    T *object = new (memory) T(std::forward<Args>(args)...);
+
+    if constexpr (!std::is_trivially_destructible_v<T>) {
+      destructors.push_back(Destructor{object, [](void *p) { static_cast<T *>(p)->~T(); }});
+    }
+
+    return object;
+  }
+
+  std::size_t bytesAllocated() const { return bytes; }
+};
+
+#endif // CLOX_ARENA_H
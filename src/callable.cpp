@@ -2,44 +2,87 @@
 #include <chrono>
 #include <iostream>
 
+Slab &Function::allocator() {
+  static auto *slab = new Slab("Function", sizeof(Function));
+  return *slab;
+}
+
 std::size_t Function::arity() { return declaration->params.size(); }
 
-std::any Function::call(Interpreter *interpreter, const std::vector<std::any> &arguments) {
-  SPEnvironment environment = std::make_shared<Environment>(closure);
+Value Function::call(Interpreter *interpreter, const std::vector<Value> &arguments) {
+  return invoke(interpreter, receiver, arguments);
+}
+
+Value Function::invoke(Interpreter *interpreter, const Value &self, const std::vector<Value> &arguments) {
+  SPEnvironment environment = frame(self);
 
   for (int i = 0; i < declaration->params.size(); i++) {
-    environment->define(declaration->params.at(i)->lexeme, arguments.at(i));
+    environment->define(arguments.at(i));
   }
 
-  try {
-    interpreter->executeBlock(declaration->body, environment);
-  } catch (ReturnValue &rv) {
-    if (isInitializer) {
-      return closure->getAt(0, "this");
-    }
+  return run(interpreter, environment);
+}
 
-    return rv.value;
+SPEnvironment Function::frame(const Value &self) {
+  SPEnvironment environment = Environment::create(closure);
+  if (closure) {
+    environment->define(self);
   }
+  return environment;
+}
+
+Value Function::run(Interpreter *interpreter, const SPEnvironment &environment) {
+  // 函数体中定义的函数和当前函数属于同一个编译单元
+  CompilationUnit *previous = interpreter->unit;
+  std::vector<Value> *previousCaptures = interpreter->captures;
+  interpreter->unit = unit.get();
+  interpreter->captures = &captures;
+
+  Completion completion = interpreter->executeBlock(declaration->body, environment);
+
+  interpreter->unit = previous;
+  interpreter->captures = previousCaptures;
 
   if (isInitializer) {
-    return closure->getAt(0, "this");
+    return environment->getAt(0, 0);
+  }
+
+  if (completion == Completion::RETURN) {
+    return std::move(interpreter->returnValue);
   }
 
   return nullptr;
 }
 
-std::string Function::toString() { return "<function " + declaration->name->lexeme + ">"; }
+std::string Function::toString() { return "<function " + std::string(declaration->name->lexeme) + ">"; }
 
 SPFunction Function::bind(SPInstance instance) {
-  closure->define("this", instance); // redefined "this"
-  return std::make_shared<Function>(declaration, closure, isInitializer);
+  auto function = makeRef<Function>(declaration, closure, isInitializer, unit, captures);
+  function->receiver = std::move(instance);
+  return function;
+}
+
+void Function::trace(Tracer &tracer) {
+  if (closure) {
+    tracer.visit(closure.get());
+  }
+  for (auto &value : captures) {
+    ::trace(tracer, value);
+  }
+  ::trace(tracer, receiver);
+}
+
+void Function::clear() {
+  closure = nullptr;
+  captures.clear();
+  receiver = nullptr;
 }
 
 std::size_t Clock::arity() { return 0; }
 
-std::any Clock::call(Interpreter *interpreter, const std::vector<std::any> &arguments) {
+Value Clock::call(Interpreter *interpreter, const std::vector<Value> &arguments) {
   auto now = std::chrono::system_clock::now();
-  return std::chrono::duration_cast<std::chrono::milliseconds>(now.time_since_epoch()).count();
+  return static_cast<double>(std::chrono::duration_cast<std::chrono::milliseconds>(now.time_since_epoch()).count());
 }
 
 std::string Clock::toString() { return "<function native-clock>"; }
@@ -48,38 +91,56 @@ int Count::count = 0;
 
 std::size_t Count::arity() { return 0; }
 
-std::any Count::call(Interpreter *interpreter, const std::vector<std::any> &arguments) { return ++count; }
+Value Count::call(Interpreter *interpreter, const std::vector<Value> &arguments) { return ++count; }
 
 std::string Count::toString() { return "<function native-count>"; }
 
+std::size_t Class::nextId = 0;
+
 std::size_t Class::arity() {
-  SPFunction initializer = findMethod("init");
   if (initializer) {
     return initializer->arity();
   }
   return 0;
 }
 
-std::any Class::call(Interpreter *interpreter, const std::vector<std::any> &arguments) {
-  SPInstance instance = std::make_shared<Instance>(interpreter, std::dynamic_pointer_cast<Class>(shared_from_this()));
+Value Class::call(Interpreter *interpreter, const std::vector<Value> &arguments) {
+  SPInstance instance = makeRef<Instance>(interpreter, SPClass(this));
 
-  SPFunction initializer = findMethod("init");
   if (initializer) {
-    initializer->bind(instance)->call(interpreter, arguments);
+    initializer->invoke(interpreter, instance, arguments);
+  }
+
+  // init没有添加字段时直接套用构造模板
+  std::size_t first = 0;
+  if (layout && instance->shape == Shape::root()) {
+    instance->shape = layout;
+    instance->fields = defaults;
+    first = templated;
+    if (first == variables.size()) {
+      return instance;
+    }
   }
 
-  // 调用var a = A()生成一个实例时，当前env中的this的会被设置为最新构建的实例
-  // 调用method之前需要bind绑定当前调用对象，this随调用对象在env中不断重新绑定
-  closure->define("this", instance);
+  // 剩下的初始化表达式在本次构造自己的环境中求值，0号槽位是正在构造的实例
+  // 这一层代替类环境挂在super环境（或空）下面，resolver算出的距离不变；初始化表达式中再构造同一个类的实例也不会改写this
+  SPEnvironment frame = Environment::create(closure->ancestor(1));
+  frame->define(instance);
 
   SPEnvironment previous = interpreter->environment;
-  interpreter->environment = closure;
+  std::vector<Value> *previousCaptures = interpreter->captures;
+  interpreter->environment = frame;
+  interpreter->captures = &captures;
 
-  auto finally = [interpreter, previous]() { interpreter->environment = previous; };
+  auto finally = [interpreter, previous, previousCaptures]() {
+    interpreter->environment = previous;
+    interpreter->captures = previousCaptures;
+  };
 
   try {
-    for (auto &variable : variables) {
-      std::any value;
+    for (std::size_t i = first; i < variables.size(); i++) {
+      VarStmt *variable = variables[i];
+      Value value;
       if (variable->initializer) {
         value = interpreter->evaluate(variable->initializer);
       }
@@ -95,98 +156,196 @@ std::any Class::call(Interpreter *interpreter, const std::vector<std::any> &argu
   return instance;
 }
 
-SPFunction Class::findMethod(const std::string &_name) {
-  auto it = methods.find(_name);
-  if (it != methods.end()) {
-    return it->second;
+void Class::prepare() {
+  for (auto &variable : variables) {
+    SPFunction method = findMethod(variable->name->lexeme);
+    if (method && method->declaration->modifier == Modifier::SETTER) {
+      return;
+    }
   }
 
-  if (superclass) {
-    return superclass->findMethod(_name);
+  Shape *shape = Shape::root();
+  for (auto &variable : variables) {
+    Expr *expression = variable->initializer;
+    if (expression && expression->kind != ExprKind::LITERAL) {
+      break;
+    }
+
+    std::string_view field = variable->name->lexeme;
+    std::size_t slot = shape->lookUp(field);
+    if (slot == Shape::NOT_FOUND) {
+      shape = shape->transition(field);
+      slot = defaults.size();
+      defaults.emplace_back();
+    }
+    defaults[slot] = expression ? static_cast<LiteralExpr *>(expression)->value : Value();
+    templated++;
+  }
+
+  layout = shape;
+}
+
+SPFunction Class::findMethod(std::string_view _name) {
+  auto it = methods.find(std::string(_name));
+  if (it != methods.end()) {
+    return it->second;
   }
 
   return nullptr;
 }
 
-std::string Class::toString() { return "<class " + name->lexeme + ">"; }
+std::string Class::toString() { return "<class " + std::string(name->lexeme) + ">"; }
 
-std::any Class::get(SPToken name) {
-  auto it = fields.find(name->lexeme);
-  if (it != fields.end()) {
-    return it->second;
+void Class::trace(Tracer &tracer) {
+  if (superclass) {
+    tracer.visit(superclass.get());
+  }
+  for (auto &[key, method] : methods) {
+    tracer.visit(method.get());
+  }
+  if (closure) {
+    tracer.visit(closure.get());
   }
+  for (auto &value : captures) {
+    ::trace(tracer, value);
+  }
+  for (auto &value : fields) {
+    ::trace(tracer, value);
+  }
+}
 
-  if (klass) {
-    SPFunction method = klass->findMethod(name->lexeme);
-    if (method) {
-      auto callable = static_cast<SPCallable>(method->bind(std::dynamic_pointer_cast<Instance>(shared_from_this())));
-      if (method->declaration->modifier == Modifier::GETTER) {
-        callable->call(interpreter, {});
-      }
-      return callable;
-    }
+void Class::clear() {
+  superclass = nullptr;
+  methods.clear();
+  initializer = nullptr;
+  closure = nullptr;
+  captures.clear();
+  shape = Shape::root();
+  fields.clear();
+}
+
+Value Class::get(SPToken name) {
+  if (Value *slot = field(name->lexeme)) {
+    return *slot;
   }
 
-  throw Interpreter::error(name, "Undefined property '" + name->lexeme + "' can't be get.");
+  // 类没有元类（klass为空），静态方法都保存在fields中
+  throw Interpreter::error(name, "Undefined property '" + std::string(name->lexeme) + "' can't be get.");
 }
 
-std::any Class::set(SPToken name, std::any value) {
-  auto it = fields.find(name->lexeme);
-  if (it != fields.end()) {
+Value Class::set(SPToken name, Value value) {
+  if (Value *slot = field(name->lexeme)) {
     // update
-    fields[name->lexeme] = value;
+    *slot = value;
     return value;
   }
 
-  if (klass) {
-    SPFunction method = klass->findMethod(name->lexeme);
-    if (method && method->declaration->modifier == Modifier::SETTER) {
-      return static_cast<SPCallable>(method->bind(std::dynamic_pointer_cast<Instance>(shared_from_this())))
-          ->call(interpreter, {value});
-    }
-  }
-
   // create
-  fields[name->lexeme] = value;
+  addField(name->lexeme, value);
   return value;
 }
 
-std::any Instance::get(SPToken name) {
-  auto it = fields.find(name->lexeme);
-  if (it != fields.end()) {
-    return it->second;
+Slab &Instance::allocator() {
+  static auto *slab = new Slab("Instance", sizeof(Instance));
+  return *slab;
+}
+
+Value Instance::get(SPToken name) {
+  if (Value *slot = field(name->lexeme)) {
+    return *slot;
   }
 
   if (klass) {
     SPFunction method = klass->findMethod(name->lexeme);
     if (method) {
-      auto callable = static_cast<SPCallable>(method->bind(shared_from_this()));
-      if (method->declaration->modifier == Modifier::GETTER) {
-        return callable->call(interpreter, {});
-      }
-      return callable;
+      return bindMethod(method.get());
     }
   }
 
-  throw Interpreter::error(name, "Undefined property '" + name->lexeme + "' can't be get.");
+  throw Interpreter::error(name, "Undefined property '" + std::string(name->lexeme) + "' can't be get.");
 }
 
-std::any Instance::set(SPToken name, std::any value) {
-  auto it = fields.find(name->lexeme);
-  if (it != fields.end()) {
+Value Instance::get(const SPToken &name, PropertyCache &cache) {
+  PropertyCache::Entry *entry = resolve(name->lexeme, cache);
+  if (entry->slot != Shape::NOT_FOUND) {
+    return fields[entry->slot];
+  }
+
+  if (entry->method) {
+    return bindMethod(entry->method);
+  }
+
+  throw Interpreter::error(name, "Undefined property '" + std::string(name->lexeme) + "' can't be get.");
+}
+
+Value Instance::set(const SPToken &name, Value value, PropertyCache &cache) {
+  PropertyCache::Entry *entry = resolve(name->lexeme, cache);
+  if (entry->slot != Shape::NOT_FOUND) {
+    fields[entry->slot] = value;
+    return value;
+  }
+
+  // setter和新建字段都不常见，走原来的路径
+  return assign(name, std::move(value));
+}
+
+PropertyCache::Entry *Instance::resolve(std::string_view name, PropertyCache &cache) {
+  PropertyCache::Entry *entry = cache.find(shape, klass->id);
+  if (!entry) {
+    entry = cache.add(shape, klass->id);
+    entry->slot = shape->lookUp(name);
+    entry->method = entry->slot == Shape::NOT_FOUND ? klass->findMethod(name).get() : nullptr;
+  }
+  return entry;
+}
+
+Function *Instance::method(const SPToken &name, PropertyCache &cache) {
+  PropertyCache::Entry *entry = resolve(name->lexeme, cache);
+  if (entry->slot == Shape::NOT_FOUND && entry->method && entry->method->declaration->modifier != Modifier::GETTER) {
+    return entry->method;
+  }
+  return nullptr;
+}
+
+Value Instance::bindMethod(Function *method) {
+  if (method->declaration->modifier == Modifier::GETTER) {
+    return method->invoke(interpreter, SPInstance(this), {});
+  }
+  return method->bind(SPInstance(this));
+}
+
+Value Instance::set(SPToken name, Value value) {
+  if (Value *slot = field(name->lexeme)) {
     // update
-    fields[name->lexeme] = value;
+    *slot = value;
     return value;
   }
 
   if (klass) {
     SPFunction method = klass->findMethod(name->lexeme);
     if (method && method->declaration->modifier == Modifier::SETTER) {
-      return static_cast<SPCallable>(method->bind(shared_from_this()))->call(interpreter, {value});
+      return method->invoke(interpreter, SPInstance(this), {value});
     }
   }
 
   // create
-  fields[name->lexeme] = value;
+  addField(name->lexeme, value);
   return value;
-}
\ No newline at end of file
+}
+
+std::string Instance::toString() { return "<instance of " + std::string(klass->name->lexeme) + ">"; }
+
+void Instance::trace(Tracer &tracer) {
+  if (klass) {
+    tracer.visit(klass.get());
+  }
+  for (auto &value : fields) {
+    ::trace(tracer, value);
+  }
+}
+
+void Instance::clear() {
+  klass = nullptr;
+  shape = Shape::root();
+  fields.clear();
+}
@@ -3,30 +3,26 @@
 
 #include "environment.h"
 #include "interpreter.h"
+#include "shape.h"
+#include <unordered_map>
 
 class Callable;
 class Function;
 class Class;
 class Instance;
 
-using SPCallable = std::shared_ptr<Callable>;
-using SPFunction = std::shared_ptr<Function>;
-using SPClass = std::shared_ptr<Class>;
-using SPInstance = std::shared_ptr<Instance>;
+using SPCallable = Ref<Callable>;
+using SPFunction = Ref<Function>;
+using SPClass = Ref<Class>;
+using SPInstance = Ref<Instance>;
 
-class Stringify {
+class Callable : public Obj {
 public:
-  virtual ~Stringify() = default;
-
-  virtual std::string toString() = 0;
-};
-
-class Callable : public Stringify {
-public:
-  virtual ~Callable() = default;
+  explicit Callable(ObjType type) : Obj(type) {}
+  ~Callable() override = default;
 
   virtual std::size_t arity() = 0;
-  virtual std::any call(Interpreter *interpreter, const std::vector<std::any> &arguments) = 0;
+  virtual Value call(Interpreter *interpreter, const std::vector<Value> &arguments) = 0;
 };
 
 class Function : public Callable {
@@ -37,24 +33,45 @@ public:
   ~Function() override = default;
 
   std::size_t arity() override;
-  std::any call(Interpreter *interpreter, const std::vector<std::any> &arguments) override;
+  Value call(Interpreter *interpreter, const std::vector<Value> &arguments) override;
+  // 以self作为接收者调用实例方法，不需要先bind出新的函数对象
+  Value invoke(Interpreter *interpreter, const Value &self, const std::vector<Value> &arguments);
+  // 创建调用环境，实例方法的接收者占0号槽位，参数由调用方依次定义在后面
+  SPEnvironment frame(const Value &self);
+  Value run(Interpreter *interpreter, const SPEnvironment &environment);
   std::string toString() override;
 
-  std::shared_ptr<FunStmt> declaration;
-  SPEnvironment closure;
-
-  explicit Function(std::shared_ptr<FunStmt> declaration, SPEnvironment closure, bool isInitializer)
-      : declaration(std::move(declaration)), closure(std::move(closure)), isInitializer(isInitializer) {}
+  FunStmt *declaration;
+  SPEnvironment closure; // 只有实例方法持有类的super环境
+  SPCompilationUnit unit; // 保证declaration所在的语法树有效
+  std::vector<Value> captures;
+  Value receiver; // bind之后的方法保存接收者
+
+  explicit Function(FunStmt *declaration, SPEnvironment closure, bool isInitializer, SPCompilationUnit unit,
+                    std::vector<Value> captures)
+      : Callable(ObjType::FUNCTION), declaration(declaration), closure(std::move(closure)),
+        isInitializer(isInitializer), unit(std::move(unit)), captures(std::move(captures)) {
+    Heap::getInstance().track(this);
+  }
 
   SPFunction bind(SPInstance instance);
+
+  // 对象内存由该类型专用的Slab分配
+  static Slab &allocator();
+  static void *operator new(std::size_t size) { return allocator().allocate(size); }
+  static void operator delete(void *pointer, std::size_t size) { allocator().deallocate(pointer, size); }
+
+  void trace(Tracer &tracer) override;
+  void clear() override;
 };
 
 class Clock : public Callable {
 public:
+  Clock() : Callable(ObjType::NATIVE) {}
   ~Clock() override = default;
 
   std::size_t arity() override;
-  std::any call(Interpreter *interpreter, const std::vector<std::any> &arguments) override;
+  Value call(Interpreter *interpreter, const std::vector<Value> &arguments) override;
   std::string toString() override;
 };
 
@@ -63,79 +80,133 @@ private:
   static int count;
 
 public:
+  Count() : Callable(ObjType::NATIVE) {}
   ~Count() override = default;
 
   std::size_t arity() override;
-  std::any call(Interpreter *interpreter, const std::vector<std::any> &arguments) override;
+  Value call(Interpreter *interpreter, const std::vector<Value> &arguments) override;
   std::string toString() override;
 };
 
-template <typename T, typename U> class Object : public Stringify, public std::enable_shared_from_this<U> {
+// 字段存取的公共实现，Class和Instance各自继承Obj作为运行时对象
+template <typename T, typename U> class Object {
 protected:
   Interpreter *interpreter;
-  std::shared_ptr<T> klass;
-  std::map<std::string, std::any> fields;
+  Ref<T> klass;
+  Shape *shape = Shape::root();
+  std::vector<Value> fields; // 按shape中的槽位保存字段值
+
+  Value *field(std::string_view name) {
+    std::size_t slot = shape->lookUp(name);
+    return slot == Shape::NOT_FOUND ? nullptr : &fields[slot];
+  }
+
+  void addField(std::string_view name, Value value) {
+    shape = shape->transition(name);
+    fields.push_back(std::move(value));
+  }
 
 public:
-  explicit Object(Interpreter *interpreter, std::shared_ptr<T> klass)
-      : interpreter(interpreter), klass(std::move(klass)) {}
+  explicit Object(Interpreter *interpreter, Ref<T> klass) : interpreter(interpreter), klass(std::move(klass)) {}
+  virtual ~Object() = default;
 
-  virtual std::any get(SPToken name) = 0;
+  virtual Value get(SPToken name) = 0;
 
-  virtual std::any set(SPToken name, std::any value) = 0;
+  virtual Value set(SPToken name, Value value) = 0;
 
-  std::any assign(SPToken name, std::any value) {
+  Value assign(SPToken name, Value value) {
     SPFunction method = nullptr;
     if (klass) {
       method = klass->findMethod(name->lexeme);
     }
-    auto it = fields.find(name->lexeme);
-
-    if (method || it != fields.end()) {
+    if (method || field(name->lexeme)) {
       return set(name, value);
     }
 
-    throw Interpreter::error(name, "Undefined property '" + name->lexeme + "' can't be assign.");
-  }
-
-  std::string toString() override {
-    if (klass) {
-      return "<instance of " + klass->name->lexeme + ">";
-    }
-    return "<instance wasn't created by class>";
+    throw Interpreter::error(name, "Undefined property '" + std::string(name->lexeme) + "' can't be assign.");
   }
 };
 
 class Class : public Callable, public Object<Class, Class> {
+private:
+  static std::size_t nextId;
+
 public:
   ~Class() override = default;
 
+  // 类释放后地址可能被新的类复用，内联缓存用唯一编号区分类
+  const std::size_t id = ++nextId;
+
   SPToken name;
   SPClass superclass;
 
-  std::map<std::string, SPFunction> methods;
-  SPFunction findMethod(const std::string &_name);
+  // 创建类时复制超类的方法表再覆盖自己的方法，查找方法不需要沿超类链逐级查找
+  std::unordered_map<std::string, SPFunction> methods;
+  Function *initializer = nullptr;
+  SPFunction findMethod(std::string_view _name);
 
-  std::vector<std::shared_ptr<VarStmt>> variables;
+  std::vector<VarStmt *> variables;
   SPEnvironment closure;
-
-  Class(Interpreter *interpreter, SPToken name, SPClass superclass, std::map<std::string, SPFunction> methods,
-        std::vector<std::shared_ptr<VarStmt>> variables, SPEnvironment closure)
-      : name(std::move(name)), superclass(std::move(superclass)), methods(std::move(methods)),
-        variables(std::move(variables)), closure(std::move(closure)), Object(interpreter, nullptr) {}
+  SPCompilationUnit unit;
+  std::vector<Value> captures; // 字段初始化表达式用到的外层变量
+
+  // 实例字段的构造模板：第一个需要求值的初始化表达式之前的字段都是常量，创建类时算好它们的shape和初始值
+  // 从那个表达式开始的字段在构造时按声明顺序逐个求值添加，初始化表达式只能看到已经添加的字段
+  // 字段名和setter同名时赋值会调用setter，这种类没有模板，仍然逐个调用Instance::set
+  Shape *layout = nullptr;
+  std::vector<Value> defaults;
+  std::size_t templated = 0; // 模板覆盖的字段声明个数
+
+  Class(Interpreter *interpreter, SPToken name, SPClass superclass,
+        std::unordered_map<std::string, SPFunction> methods, std::vector<VarStmt *> variables, SPEnvironment closure,
+        SPCompilationUnit unit, std::vector<Value> captures)
+      : Callable(ObjType::CLASS), Object(interpreter, nullptr), name(std::move(name)),
+        superclass(std::move(superclass)), methods(std::move(methods)), variables(std::move(variables)),
+        closure(std::move(closure)), unit(std::move(unit)), captures(std::move(captures)) {
+    initializer = findMethod("init").get();
+    prepare();
+    Heap::getInstance().track(this);
+  }
 
   std::size_t arity() override;
-  std::any call(Interpreter *interpreter, const std::vector<std::any> &arguments) override;
-  std::any get(SPToken name) override;
-  std::any set(SPToken name, std::any value) override;
+  Value call(Interpreter *interpreter, const std::vector<Value> &arguments) override;
+  Value get(SPToken name) override;
+  Value set(SPToken name, Value value) override;
   std::string toString() override;
+  void trace(Tracer &tracer) override;
+  void clear() override;
+
+private:
+  void prepare();
 };
 
-class Instance : public Object<Class, Instance> {
+class Instance : public Obj, public Object<Class, Instance> {
+private:
+  friend class Class;
+
+  PropertyCache::Entry *resolve(std::string_view name, PropertyCache &cache);
+  Value bindMethod(Function *method);
+
 public:
-  explicit Instance(Interpreter *interpreter, SPClass klass) : Object(interpreter, std::move(klass)) {}
-  std::any get(SPToken name) override;
-  std::any set(SPToken name, std::any value) override;
+  explicit Instance(Interpreter *interpreter, SPClass klass)
+      : Obj(ObjType::INSTANCE), Object(interpreter, std::move(klass)) {
+    Heap::getInstance().track(this);
+  }
+
+  // 对象内存由该类型专用的Slab分配
+  static Slab &allocator();
+  static void *operator new(std::size_t size) { return allocator().allocate(size); }
+  static void operator delete(void *pointer, std::size_t size) { allocator().deallocate(pointer, size); }
+  Value get(SPToken name) override;
+  Value set(SPToken name, Value value) override;
+  // 带内联缓存的属性访问，缓存命中时跳过字段查找和沿超类查找方法
+  Value get(const SPToken &name, PropertyCache &cache);
+  Value set(const SPToken &name, Value value, PropertyCache &cache);
+  // obj.method(args)直接调用时使用：属性是普通方法时返回该方法，是字段或getter时返回nullptr
+  Function *method(const SPToken &name, PropertyCache &cache);
+  std::string toString() override;
+  void trace(Tracer &tracer) override;
+  void clear() override;
 };
 
 #endif // CLOX_CALLABLE_H
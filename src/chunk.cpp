@@ -0,0 +1,25 @@
+#include "chunk.h"
+#include <algorithm>
+
+int Chunk::addConstant(const Value &value) {
+  constants.push_back(value);
+  return static_cast<int>(constants.size()) - 1;
+}
+
+void Chunk::mark(SPToken token) {
+  auto offset = static_cast<int>(code.size());
+  if (!tokens.empty() && tokens.back().first == offset) {
+    tokens.back().second = std::move(token);
+    return;
+  }
+  tokens.emplace_back(offset, std::move(token));
+}
+
+SPToken Chunk::tokenAt(int offset) const {
+  auto it = std::upper_bound(tokens.begin(), tokens.end(), offset,
+                             [](int value, const std::pair<int, SPToken> &item) { return value < item.first; });
+  if (it == tokens.begin()) {
+    return nullptr;
+  }
+  return std::prev(it)->second;
+}
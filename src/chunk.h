@@ -0,0 +1,78 @@
+#ifndef CLOX_CHUNK_H
+#define CLOX_CHUNK_H
+
+#include "token.h"
+#include "value.h"
+#include <cstdint>
+#include <utility>
+#include <vector>
+
+enum class OpCode : std::uint8_t {
+  CONSTANT, // u16 常量下标
+  NIL,
+  TRUE,
+  FALSE,
+  POP,
+
+  GET_LOCAL,      // u8 栈槽
+  SET_LOCAL,      // u8 栈槽
+  GET_UPVALUE,    // u8 upvalue下标
+  SET_UPVALUE,    // u8 upvalue下标
+  GET_GLOBAL,     // u16 名称常量
+  DEFINE_GLOBAL,  // u16 名称常量
+  SET_GLOBAL,     // u16 名称常量
+  SET_UNRESOLVED, // u16 名称常量，resolver没有找到的赋值目标，执行时报错
+
+  GET_PROPERTY, // u16 名称常量
+  SET_PROPERTY, // u16 名称常量，u8 是否返回原值
+  GET_SUPER,    // u16 名称常量
+
+  EQUAL,
+  GREATER,
+  GREATER_EQUAL,
+  LESS,
+  LESS_EQUAL,
+  ADD,
+  SUBTRACT,
+  MULTIPLY,
+  DIVIDE,
+  POWER,
+  NOT,
+  NEGATE,
+  POSITIVE,
+
+  PRINT,
+  JUMP,          // u16 向前偏移
+  JUMP_IF_FALSE, // u16 向前偏移，不弹出条件
+  LOOP,          // u16 向后偏移
+
+  CALL,    // u8 参数个数
+  CLOSURE, // u16 函数常量，随后每个upvalue两个字节：是否局部变量、下标
+  CLOSE_UPVALUE,
+  RETURN,
+
+  CLASS, // u16 名称常量
+  INHERIT,
+  METHOD, // u16 名称常量
+  FIELD_INITIALIZER,
+  DEFINE_FIELD, // u16 名称常量
+  STATIC_FIELD, // u16 名称常量
+};
+
+class Chunk {
+private:
+  // 按字节码偏移升序记录可能出错的指令对应的token，用于报告运行时错误
+  std::vector<std::pair<int, SPToken>> tokens;
+
+public:
+  std::vector<std::uint8_t> code;
+  std::vector<Value> constants;
+
+  void write(std::uint8_t byte) { code.push_back(byte); }
+  int addConstant(const Value &value);
+
+  void mark(SPToken token);
+  SPToken tokenAt(int offset) const;
+};
+
+#endif // CLOX_CHUNK_H
@@ -0,0 +1,24 @@
+#ifndef CLOX_COMPILATION_UNIT_H
+#define CLOX_COMPILATION_UNIT_H
+
+#include "arena.h"
+#include "source_buffer.h"
+#include "stmt.h"
+#include "token.h"
+#include <memory>
+#include <string>
+#include <vector>
+
+// 一次runCode的全部产物：源码、token、语法树和分配语法树的Arena
+// 运行时的函数和类持有它，保证引用的语法树节点和token在使用期间有效
+class CompilationUnit : public std::enable_shared_from_this<CompilationUnit> {
+public:
+  SourceBuffer source; // token的lexeme指向这里
+  Arena arena;
+  std::vector<Token> tokens;
+  std::vector<Stmt *> statements;
+};
+
+using SPCompilationUnit = std::shared_ptr<CompilationUnit>;
+
+#endif // CLOX_COMPILATION_UNIT_H
@@ -0,0 +1,649 @@
+#include "compiler.h"
+#include "lox.h"
+#include <limits>
+
+void Compiler::reset() {
+  current = nullptr;
+  unit = nullptr;
+}
+
+Chunk &Compiler::chunk() { return current->proto->chunk; }
+
+void Compiler::emitByte(std::uint8_t byte) { chunk().write(byte); }
+
+void Compiler::emitOp(OpCode op) { emitByte(static_cast<std::uint8_t>(op)); }
+
+void Compiler::emitOp(OpCode op, SPToken token) {
+  chunk().mark(std::move(token));
+  emitOp(op);
+}
+
+void Compiler::emitShort(std::uint16_t value) {
+  emitByte(static_cast<std::uint8_t>((value >> 8) & 0xff));
+  emitByte(static_cast<std::uint8_t>(value & 0xff));
+}
+
+void Compiler::emitConstant(const Value &value, SPToken token) {
+  std::uint16_t constant = makeConstant(value, std::move(token));
+  emitOp(OpCode::CONSTANT);
+  emitShort(constant);
+}
+
+void Compiler::emitReturn() {
+  if (current->type == FunctionType::INITIALIZER) {
+    emitOp(OpCode::GET_LOCAL);
+    emitByte(0); // init总是返回this
+  } else {
+    emitOp(OpCode::NIL);
+  }
+  emitOp(OpCode::RETURN);
+}
+
+int Compiler::emitJump(OpCode op) {
+  emitOp(op);
+  emitShort(0xffff);
+  return static_cast<int>(chunk().code.size()) - 2;
+}
+
+void Compiler::patchJump(int offset, SPToken token) {
+  int jump = static_cast<int>(chunk().code.size()) - offset - 2;
+
+  if (jump > std::numeric_limits<std::uint16_t>::max()) {
+    throw error(std::move(token), "Too much code to jump over.");
+  }
+
+  chunk().code.at(offset) = static_cast<std::uint8_t>((jump >> 8) & 0xff);
+  chunk().code.at(offset + 1) = static_cast<std::uint8_t>(jump & 0xff);
+}
+
+void Compiler::emitLoop(int loopStart, SPToken token) {
+  emitOp(OpCode::LOOP);
+
+  int offset = static_cast<int>(chunk().code.size()) - loopStart + 2;
+  if (offset > std::numeric_limits<std::uint16_t>::max()) {
+    throw error(std::move(token), "Loop body too large.");
+  }
+
+  emitShort(static_cast<std::uint16_t>(offset));
+}
+
+std::uint16_t Compiler::makeConstant(const Value &value, SPToken token) {
+  int constant = chunk().addConstant(value);
+  if (constant > std::numeric_limits<std::uint16_t>::max()) {
+    throw error(std::move(token), "Too many constants in one chunk.");
+  }
+  return static_cast<std::uint16_t>(constant);
+}
+
+std::uint16_t Compiler::identifierConstant(SPToken name) {
+  auto it = current->identifiers.find(name->lexeme);
+  if (it != current->identifiers.end()) {
+    return it->second;
+  }
+
+  std::uint16_t constant = makeConstant(std::string(name->lexeme), name);
+  current->identifiers.emplace(name->lexeme, constant);
+  return constant;
+}
+
+void Compiler::beginScope() { current->scopeDepth++; }
+
+void Compiler::endScope() {
+  current->scopeDepth--;
+
+  while (!current->locals.empty() && current->locals.back().depth > current->scopeDepth) {
+    if (current->locals.back().isCaptured) {
+      emitOp(OpCode::CLOSE_UPVALUE);
+    } else {
+      emitOp(OpCode::POP);
+    }
+    current->locals.pop_back();
+  }
+}
+
+// 顶层作用域对应解释器的globals，变量按名字保存
+bool Compiler::isGlobalScope() { return current->type == FunctionType::NONE && current->scopeDepth == 0; }
+
+int Compiler::addLocal(std::string_view name, SPToken token) {
+  if (current->locals.size() > std::numeric_limits<std::uint8_t>::max()) {
+    throw error(std::move(token), "Too many local variables in function.");
+  }
+
+  current->locals.push_back(Local{std::string(name), current->scopeDepth, false});
+  return static_cast<int>(current->locals.size()) - 1;
+}
+
+int Compiler::resolveLocal(FunctionState *state, std::string_view name) {
+  for (auto i = static_cast<int>(state->locals.size()) - 1; i >= 0; i--) {
+    if (state->locals.at(i).name == name) {
+      return i;
+    }
+  }
+  return -1;
+}
+
+int Compiler::resolveUpvalue(FunctionState *state, std::string_view name, SPToken token) { // NOLINT(*-no-recursion)
+  if (!state->enclosing) {
+    return -1;
+  }
+
+  int local = resolveLocal(state->enclosing, name);
+  if (local != -1) {
+    state->enclosing->locals.at(local).isCaptured = true;
+    return addUpvalue(state, static_cast<std::uint8_t>(local), true, std::move(token));
+  }
+
+  int upvalue = resolveUpvalue(state->enclosing, name, token);
+  if (upvalue != -1) {
+    return addUpvalue(state, static_cast<std::uint8_t>(upvalue), false, std::move(token));
+  }
+
+  return -1;
+}
+
+int Compiler::addUpvalue(FunctionState *state, std::uint8_t index, bool isLocal, SPToken token) {
+  for (int i = 0; i < state->upvalues.size(); i++) {
+    Upvalue &upvalue = state->upvalues.at(i);
+    if (upvalue.index == index && upvalue.isLocal == isLocal) {
+      return i;
+    }
+  }
+
+  if (state->upvalues.size() > std::numeric_limits<std::uint8_t>::max()) {
+    throw error(std::move(token), "Too many closure variables in function.");
+  }
+
+  state->upvalues.push_back(Upvalue{index, isLocal});
+  return static_cast<int>(state->upvalues.size()) - 1;
+}
+
+void Compiler::emitGetVariable(SPToken name) {
+  int arg = resolveLocal(current, name->lexeme);
+  if (arg != -1) {
+    emitOp(OpCode::GET_LOCAL);
+    emitByte(static_cast<std::uint8_t>(arg));
+    return;
+  }
+
+  arg = resolveUpvalue(current, name->lexeme, name);
+  if (arg != -1) {
+    emitOp(OpCode::GET_UPVALUE);
+    emitByte(static_cast<std::uint8_t>(arg));
+    return;
+  }
+
+  std::uint16_t constant = identifierConstant(name);
+  emitOp(OpCode::GET_GLOBAL, name);
+  emitShort(constant);
+}
+
+void Compiler::emitSetVariable(SPToken name) {
+  int arg = resolveLocal(current, name->lexeme);
+  if (arg != -1) {
+    emitOp(OpCode::SET_LOCAL);
+    emitByte(static_cast<std::uint8_t>(arg));
+    return;
+  }
+
+  arg = resolveUpvalue(current, name->lexeme, name);
+  if (arg != -1) {
+    emitOp(OpCode::SET_UPVALUE);
+    emitByte(static_cast<std::uint8_t>(arg));
+    return;
+  }
+
+  std::uint16_t constant = identifierConstant(name);
+  emitOp(OpCode::SET_GLOBAL, name);
+  emitShort(constant);
+}
+
+void Compiler::beginFunction(FunctionState &state, SPToken name, FunctionType type) {
+  state.enclosing = current;
+  state.proto = makeRef<ObjProto>(std::move(name));
+  state.proto->unit = unit->shared_from_this();
+  state.type = type;
+  current = &state;
+
+  // 第0个栈槽保存被调用的函数，方法中则是this
+  bool isMethod = type == FunctionType::METHOD || type == FunctionType::INITIALIZER;
+  current->locals.push_back(Local{isMethod ? "this" : "", 0, false});
+}
+
+SPProto Compiler::endFunction() {
+  emitReturn();
+
+  SPProto proto = current->proto;
+  proto->upvalueCount = static_cast<int>(current->upvalues.size());
+
+  current = current->enclosing;
+  return proto;
+}
+
+void Compiler::emitClosure(FunctionState &state, SPProto proto, SPToken token) {
+  std::uint16_t constant = makeConstant(proto, std::move(token));
+  emitOp(OpCode::CLOSURE);
+  emitShort(constant);
+
+  for (auto &upvalue : state.upvalues) {
+    emitByte(upvalue.isLocal ? 1 : 0);
+    emitByte(upvalue.index);
+  }
+}
+
+void Compiler::function(FunStmt *stmt, FunctionType type) {
+  FunctionState state;
+  beginFunction(state, stmt->name, type);
+  beginScope();
+
+  current->proto->arity = static_cast<int>(stmt->params.size());
+  current->proto->modifier = stmt->modifier;
+
+  for (auto &param : stmt->params) {
+    addLocal(param->lexeme, param);
+  }
+
+  for (auto &statement : stmt->body->statements) {
+    compile(statement);
+  }
+
+  SPProto proto = endFunction();
+  emitClosure(state, proto, stmt->name);
+}
+
+// 实例字段的初始化表达式打包成一个以this为第0个栈槽的函数
+void Compiler::fieldInitializer(ClassStmt *stmt) {
+  FunctionState state;
+  beginFunction(state, stmt->name, FunctionType::METHOD);
+  beginScope();
+
+  for (auto &variable : stmt->instanceAttributes.variables) {
+    emitOp(OpCode::GET_LOCAL);
+    emitByte(0);
+
+    if (variable->initializer) {
+      compile(variable->initializer);
+    } else {
+      emitOp(OpCode::NIL);
+    }
+
+    std::uint16_t constant = identifierConstant(variable->name);
+    emitOp(OpCode::DEFINE_FIELD, variable->name);
+    emitShort(constant);
+  }
+
+  SPProto proto = endFunction();
+  emitClosure(state, proto, stmt->name);
+}
+
+void Compiler::visitBinaryExpr(BinaryExpr *expr) {
+  compile(expr->left);
+  compile(expr->right);
+
+  switch (expr->op->type) {
+    case TokenType::MINUS: {
+      emitOp(OpCode::SUBTRACT, expr->op);
+      break;
+    }
+    case TokenType::SLASH: {
+      emitOp(OpCode::DIVIDE, expr->op);
+      break;
+    }
+    case TokenType::STAR: {
+      emitOp(OpCode::MULTIPLY, expr->op);
+      break;
+    }
+    case TokenType::PLUS: {
+      emitOp(OpCode::ADD, expr->op);
+      break;
+    }
+    case TokenType::GREATER: {
+      emitOp(OpCode::GREATER, expr->op);
+      break;
+    }
+    case TokenType::GREATER_EQUAL: {
+      emitOp(OpCode::GREATER_EQUAL, expr->op);
+      break;
+    }
+    case TokenType::LESS: {
+      emitOp(OpCode::LESS, expr->op);
+      break;
+    }
+    case TokenType::LESS_EQUAL: {
+      emitOp(OpCode::LESS_EQUAL, expr->op);
+      break;
+    }
+    case TokenType::BANG_EQUAL: {
+      emitOp(OpCode::EQUAL);
+      emitOp(OpCode::NOT);
+      break;
+    }
+    case TokenType::EQUAL_EQUAL: {
+      emitOp(OpCode::EQUAL);
+      break;
+    }
+    case TokenType::STAR_STAR: {
+      emitOp(OpCode::POWER, expr->op);
+      break;
+    }
+    default: {
+      throw error(expr->op, "Unexpected operator type.");
+    }
+  }
+}
+
+void Compiler::visitGroupingExpr(GroupingExpr *expr) { compile(expr->expression); }
+
+void Compiler::visitUnaryExpr(UnaryExpr *expr) {
+  compile(expr->right);
+
+  switch (expr->op->type) {
+    case TokenType::BANG: {
+      emitOp(OpCode::NOT);
+      break;
+    }
+    case TokenType::PLUS: {
+      emitOp(OpCode::POSITIVE, expr->op);
+      break;
+    }
+    case TokenType::MINUS: {
+      emitOp(OpCode::NEGATE, expr->op);
+      break;
+    }
+    default: {
+      throw error(expr->op, "Unexpected operator type.");
+    }
+  }
+}
+
+void Compiler::visitLiteralExpr(LiteralExpr *expr) {
+  if (expr->value.isNil()) {
+    emitOp(OpCode::NIL);
+  } else if (expr->value.isBool()) {
+    emitOp(expr->value.asBool() ? OpCode::TRUE : OpCode::FALSE);
+  } else {
+    emitConstant(expr->value, nullptr);
+  }
+}
+
+void Compiler::visitVariableExpr(VariableExpr *expr) { emitGetVariable(expr->name); }
+
+void Compiler::visitAssignExpr(AssignExpr *expr) {
+  // 和解释器保持一致，resolver没有解析到的赋值目标在执行时报错
+  if (!expr->resolution.isResolved()) {
+    compile(expr->value);
+    std::uint16_t constant = identifierConstant(expr->name);
+    emitOp(OpCode::SET_UNRESOLVED, expr->name);
+    emitShort(constant);
+    return;
+  }
+
+  if (expr->returnOriginal) {
+    emitGetVariable(expr->name);
+  }
+
+  compile(expr->value);
+  emitSetVariable(expr->name);
+
+  if (expr->returnOriginal) {
+    emitOp(OpCode::POP);
+  }
+}
+
+void Compiler::visitLogicalExpr(LogicalExpr *expr) {
+  compile(expr->left);
+
+  // or/and
+  if (expr->op->type == TokenType::OR) {
+    int elseJump = emitJump(OpCode::JUMP_IF_FALSE);
+    int endJump = emitJump(OpCode::JUMP);
+    patchJump(elseJump, expr->op);
+    emitOp(OpCode::POP);
+    compile(expr->right);
+    patchJump(endJump, expr->op);
+  } else {
+    int endJump = emitJump(OpCode::JUMP_IF_FALSE);
+    emitOp(OpCode::POP);
+    compile(expr->right);
+    patchJump(endJump, expr->op);
+  }
+}
+
+void Compiler::visitCallExpr(CallExpr *expr) {
+  compile(expr->callee);
+
+  for (auto &argument : expr->arguments) {
+    compile(argument);
+  }
+
+  emitOp(OpCode::CALL, expr->paren);
+  emitByte(static_cast<std::uint8_t>(expr->arguments.size()));
+}
+
+void Compiler::visitGetExpr(GetExpr *expr) {
+  compile(expr->object);
+
+  std::uint16_t constant = identifierConstant(expr->name);
+  emitOp(OpCode::GET_PROPERTY, expr->name);
+  emitShort(constant);
+}
+
+void Compiler::visitSetExpr(SetExpr *expr) {
+  compile(expr->object);
+  compile(expr->value);
+
+  std::uint16_t constant = identifierConstant(expr->name);
+  emitOp(OpCode::SET_PROPERTY, expr->name);
+  emitShort(constant);
+  emitByte(expr->returnOriginal ? 1 : 0);
+}
+
+void Compiler::visitThisExpr(ThisExpr *expr) { emitGetVariable(expr->keyword); }
+
+void Compiler::visitSuperExpr(SuperExpr *expr) {
+  emitGetVariable(unit->arena.make<Token>(TokenType::THIS, "this", nullptr, expr->keyword->line));
+  emitGetVariable(expr->keyword); // "super"
+
+  std::uint16_t constant = identifierConstant(expr->method);
+  emitOp(OpCode::GET_SUPER, expr->method);
+  emitShort(constant);
+}
+
+void Compiler::visitExprStmt(ExprStmt *stmt) {
+  compile(stmt->expression);
+  emitOp(OpCode::POP);
+}
+
+void Compiler::visitReturnStmt(ReturnStmt *stmt) {
+  if (!stmt->value) {
+    emitReturn();
+    return;
+  }
+
+  compile(stmt->value);
+  emitOp(OpCode::RETURN);
+}
+
+void Compiler::visitPrintStmt(PrintStmt *stmt) {
+  compile(stmt->expression);
+  emitOp(OpCode::PRINT);
+}
+
+void Compiler::visitFunStmt(FunStmt *stmt) {
+  if (isGlobalScope()) {
+    function(stmt, FunctionType::FUNCTION);
+    std::uint16_t constant = identifierConstant(stmt->name);
+    emitOp(OpCode::DEFINE_GLOBAL);
+    emitShort(constant);
+    return;
+  }
+
+  addLocal(stmt->name->lexeme, stmt->name); // 先声明，允许递归调用
+  function(stmt, FunctionType::FUNCTION);
+}
+
+void Compiler::visitClassStmt(ClassStmt *stmt) {
+  bool global = isGlobalScope();
+  if (global) {
+    beginScope(); // 全局的类在定义完成前先作为匿名局部变量保存
+  }
+
+  std::uint16_t nameConstant = identifierConstant(stmt->name);
+  emitOp(OpCode::CLASS);
+  emitShort(nameConstant);
+  int classSlot = addLocal(global ? "" : stmt->name->lexeme, stmt->name);
+
+  beginScope();
+
+  // 允许在上下文中注入super，像this一样的操作
+  if (stmt->superclass) {
+    compile(stmt->superclass);
+    emitOp(OpCode::INHERIT, stmt->superclass->name);
+    addLocal("super", stmt->superclass->name);
+  }
+
+  emitOp(OpCode::GET_LOCAL);
+  emitByte(static_cast<std::uint8_t>(classSlot));
+
+  for (auto &method : stmt->instanceAttributes.methods) {
+    FunctionType type = FunctionType::METHOD;
+    if (method->name->lexeme == "init") {
+      type = FunctionType::INITIALIZER;
+    }
+    function(method, type);
+
+    std::uint16_t constant = identifierConstant(method->name);
+    emitOp(OpCode::METHOD);
+    emitShort(constant);
+  }
+
+  if (!stmt->instanceAttributes.variables.empty()) {
+    fieldInitializer(stmt);
+    emitOp(OpCode::FIELD_INITIALIZER);
+  }
+
+  emitOp(OpCode::POP);
+  endScope();
+
+  // 静态属性在类所在的作用域中求值，不能访问this和super
+  for (auto &variable : stmt->staticAttributes.variables) {
+    if (variable->initializer) {
+      compile(variable->initializer);
+    } else {
+      emitOp(OpCode::NIL);
+    }
+
+    std::uint16_t constant = identifierConstant(variable->name);
+    emitOp(OpCode::STATIC_FIELD);
+    emitShort(constant);
+  }
+
+  for (auto &method : stmt->staticAttributes.methods) {
+    function(method, FunctionType::FUNCTION);
+
+    std::uint16_t constant = identifierConstant(method->name);
+    emitOp(OpCode::STATIC_FIELD);
+    emitShort(constant);
+  }
+
+  if (global) {
+    emitOp(OpCode::GET_LOCAL);
+    emitByte(static_cast<std::uint8_t>(classSlot));
+    emitOp(OpCode::DEFINE_GLOBAL);
+    emitShort(nameConstant);
+    endScope();
+  }
+}
+
+void Compiler::visitVarStmt(VarStmt *stmt) {
+  if (stmt->initializer) {
+    compile(stmt->initializer);
+  } else {
+    emitOp(OpCode::NIL);
+  }
+
+  if (isGlobalScope()) {
+    std::uint16_t constant = identifierConstant(stmt->name);
+    emitOp(OpCode::DEFINE_GLOBAL);
+    emitShort(constant);
+    return;
+  }
+
+  addLocal(stmt->name->lexeme, stmt->name);
+}
+
+void Compiler::visitBlockStmt(BlockStmt *stmt) {
+  beginScope();
+  for (auto &statement : stmt->statements) {
+    compile(statement);
+  }
+  endScope();
+}
+
+void Compiler::visitIfStmt(IfStmt *stmt) {
+  compile(stmt->condition);
+
+  int thenJump = emitJump(OpCode::JUMP_IF_FALSE);
+  emitOp(OpCode::POP);
+  compile(stmt->thenBranch);
+
+  int elseJump = emitJump(OpCode::JUMP);
+  patchJump(thenJump, chunk().tokenAt(thenJump));
+  emitOp(OpCode::POP);
+
+  if (stmt->elseBranch) {
+    compile(stmt->elseBranch);
+  }
+  patchJump(elseJump, chunk().tokenAt(elseJump));
+}
+
+void Compiler::visitWhileStmt(WhileStmt *stmt) {
+  auto loopStart = static_cast<int>(chunk().code.size());
+  compile(stmt->condition);
+
+  int exitJump = emitJump(OpCode::JUMP_IF_FALSE);
+  emitOp(OpCode::POP);
+  compile(stmt->body);
+  emitLoop(loopStart, chunk().tokenAt(exitJump));
+
+  patchJump(exitJump, chunk().tokenAt(exitJump));
+  emitOp(OpCode::POP);
+}
+
+void Compiler::compile(Stmt *stmt) { visitStmt(stmt); }
+
+void Compiler::compile(Expr *expr) { visitExpr(expr); }
+
+CompileError Compiler::error(SPToken token, const std::string &message) {
+  if (token) {
+    lox::error(std::move(token), message);
+  } else {
+    lox::error(0, message);
+  }
+  return {};
+}
+
+SPProto Compiler::compile(CompilationUnit &_unit) {
+  reset();
+  unit = &_unit;
+
+  FunctionState state;
+  beginFunction(state, nullptr, FunctionType::NONE);
+
+  try {
+    for (auto &statement : unit->statements) {
+      compile(statement);
+    }
+  } catch (CompileError &err) {
+    reset();
+    return nullptr;
+  }
+
+  SPProto script = endFunction();
+  reset();
+  return script;
+}
+
+Compiler &Compiler::getInstance() {
+  static Compiler instance;
+  return instance;
+}
@@ -0,0 +1,113 @@
+#ifndef CLOX_COMPILER_H
+#define CLOX_COMPILER_H
+
+#include "compilation_unit.h"
+#include "expr.h"
+#include "resolver.h"
+#include "stmt.h"
+#include "vm_object.h"
+#include <map>
+
+class CompileError : public std::exception {};
+
+// 把resolver处理过的语法树编译成字节码，交给VM执行
+class Compiler : public ExprVisitor<void>, StmtVisitor<void> {
+private:
+  struct Local {
+    std::string name;
+    int depth;
+    bool isCaptured;
+  };
+
+  struct Upvalue {
+    std::uint8_t index;
+    bool isLocal;
+  };
+
+  struct FunctionState {
+    FunctionState *enclosing;
+    SPProto proto;
+    FunctionType type;
+    std::vector<Local> locals;
+    std::vector<Upvalue> upvalues;
+    std::map<std::string, std::uint16_t, std::less<>> identifiers;
+    int scopeDepth = 0;
+  };
+
+  FunctionState *current = nullptr;
+  // 编译出的函数持有编译单元，chunk中记录的token在运行期间保持有效
+  CompilationUnit *unit = nullptr;
+
+  void reset();
+
+  Chunk &chunk();
+
+  void emitByte(std::uint8_t byte);
+  void emitOp(OpCode op);
+  void emitOp(OpCode op, SPToken token);
+  void emitShort(std::uint16_t value);
+  void emitConstant(const Value &value, SPToken token);
+  void emitReturn();
+  int emitJump(OpCode op);
+  void patchJump(int offset, SPToken token);
+  void emitLoop(int loopStart, SPToken token);
+
+  std::uint16_t makeConstant(const Value &value, SPToken token);
+  std::uint16_t identifierConstant(SPToken name);
+
+  void beginScope();
+  void endScope();
+  bool isGlobalScope();
+  int addLocal(std::string_view name, SPToken token);
+
+  static int resolveLocal(FunctionState *state, std::string_view name);
+  static int resolveUpvalue(FunctionState *state, std::string_view name, SPToken token);
+  static int addUpvalue(FunctionState *state, std::uint8_t index, bool isLocal, SPToken token);
+
+  void emitGetVariable(SPToken name);
+  void emitSetVariable(SPToken name);
+
+  void beginFunction(FunctionState &state, SPToken name, FunctionType type);
+  SPProto endFunction();
+  void emitClosure(FunctionState &state, SPProto proto, SPToken token);
+  void function(FunStmt *stmt, FunctionType type);
+  void fieldInitializer(ClassStmt *stmt);
+
+  void visitBinaryExpr(BinaryExpr *expr) override;
+  void visitGroupingExpr(GroupingExpr *expr) override;
+  void visitUnaryExpr(UnaryExpr *expr) override;
+  void visitLiteralExpr(LiteralExpr *expr) override;
+  void visitVariableExpr(VariableExpr *expr) override;
+  void visitAssignExpr(AssignExpr *expr) override;
+  void visitLogicalExpr(LogicalExpr *expr) override;
+  void visitCallExpr(CallExpr *expr) override;
+  void visitGetExpr(GetExpr *expr) override;
+  void visitSetExpr(SetExpr *expr) override;
+  void visitThisExpr(ThisExpr *expr) override;
+  void visitSuperExpr(SuperExpr *expr) override;
+
+  void visitExprStmt(ExprStmt *stmt) override;
+  void visitReturnStmt(ReturnStmt *stmt) override;
+  void visitPrintStmt(PrintStmt *stmt) override;
+  void visitFunStmt(FunStmt *stmt) override;
+  void visitClassStmt(ClassStmt *stmt) override;
+  void visitVarStmt(VarStmt *stmt) override;
+  void visitBlockStmt(BlockStmt *stmt) override;
+  void visitIfStmt(IfStmt *stmt) override;
+  void visitWhileStmt(WhileStmt *stmt) override;
+
+  void compile(Stmt *stmt);
+  void compile(Expr *expr);
+
+  Compiler() = default;
+
+public:
+  static Compiler &getInstance();
+  Compiler(const Compiler &) = delete;
+  Compiler &operator=(const Compiler &) = delete;
+
+  static CompileError error(SPToken token, const std::string &message);
+  SPProto compile(CompilationUnit &_unit);
+};
+
+#endif // CLOX_COMPILER_H
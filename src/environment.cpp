@@ -1,48 +1,112 @@
 #include "environment.h"
 #include "interpreter.h"
 
-void Environment::define(const std::string &name, const std::any &value) { values[name] = value; }
+namespace {
 
-std::any Environment::get(SPToken name) { // NOLINT(*-no-recursion)
-  auto it = values.find(name->lexeme);
-  if (it != values.end()) {
-    return it->second;
-  }
+struct EnvironmentPool {
+  std::vector<Environment *> environments;
 
-  if (enclosing) {
-    return enclosing->get(name);
+  ~EnvironmentPool() {
+    for (Environment *environment : environments) {
+      delete environment;
+    }
   }
+};
+
+} // namespace
 
-  throw Interpreter::error(name, "Undefined variable '" + name->lexeme + "'.");
+std::vector<Environment *> &Environment::pool() {
+  static EnvironmentPool instance;
+  return instance.environments;
 }
 
-std::any Environment::getAt(int distance, const std::string &name) { return ancestor(distance)->values.at(name); }
+Slab &Environment::allocator() {
+  // 不析构，退出时全局对象释放的环境仍然可以归还
+  static auto *slab = new Slab("Environment", sizeof(Environment));
+  return *slab;
+}
 
-SPEnvironment Environment::ancestor(int distance) {
-  SPEnvironment environment = shared_from_this();
+SPEnvironment Environment::create(SPEnvironment enclosing) {
+  std::vector<Environment *> &environments = pool();
 
-  for (int i = 0; i < distance; i++) {
-    environment = environment->enclosing;
+  Environment *environment;
+  if (environments.empty()) {
+    environment = new Environment();
+  } else {
+    environment = environments.back();
+    environments.pop_back();
   }
 
+  environment->enclosing = std::move(enclosing);
+  Heap::getInstance().track(environment);
   return environment;
 }
 
-void Environment::assign(SPToken name, const std::any &value) { // NOLINT(*-no-recursion)
-  auto it = values.find(name->lexeme);
+void Environment::destroy() {
+  // 清空槽位可能释放其他环境，它们会先于当前环境进入空闲池
+  clear();
+  Heap::getInstance().untrack(this);
+
+  std::vector<Environment *> &environments = pool();
+  if (environments.size() < POOL_MAX) {
+    environments.push_back(this);
+  } else {
+    delete this;
+  }
+}
+
+void Environment::trace(Tracer &tracer) {
+  for (auto &[name, value] : values) {
+    ::trace(tracer, value);
+  }
+  for (auto &value : slots) {
+    ::trace(tracer, value);
+  }
+  if (enclosing) {
+    tracer.visit(enclosing.get());
+  }
+}
+
+void Environment::clear() {
+  values.clear();
+  slots.clear();
+  enclosing = nullptr;
+}
+
+void Environment::define(const std::string &name, const Value &value) { values[name] = value; }
+
+Value Environment::get(const SPToken &name) { return *cell(name); }
+
+void Environment::assign(const SPToken &name, const Value &value) { *cell(name) = value; }
+
+Value *Environment::cell(const SPToken &name) { // NOLINT(*-no-recursion)
+  auto it = values.find(std::string(name->lexeme));
   if (it != values.end()) {
-    values[name->lexeme] = value;
-    return;
+    return &it->second;
   }
 
   if (enclosing) {
-    enclosing->assign(name, value);
-    return;
+    return enclosing->cell(name);
   }
 
-  throw Interpreter::error(name, "Undefined variable '" + name->lexeme + "'.");
+  throw Interpreter::error(name, "Undefined variable '" + std::string(name->lexeme) + "'.");
 }
 
-void Environment::assignAt(int distance, const std::string &name, const std::any &value) {
-  ancestor(distance)->values[name] = value;
+void Environment::defineAt(int slot, const Value &value) {
+  if (slot >= slots.size()) {
+    slots.resize(slot + 1);
+  }
+  slots.at(slot) = value;
 }
+
+Environment *Environment::ancestor(int distance) {
+  Environment *environment = this;
+
+  for (int i = 0; i < distance; i++) {
+    environment = environment->enclosing.get();
+  }
+
+  return environment;
+}
+
+Value &Environment::getAt(int distance, int slot) { return ancestor(distance)->slots.at(slot); }
@@ -1,30 +1,75 @@
 #ifndef CLOX_ENVIRONMENT_H
 #define CLOX_ENVIRONMENT_H
 
+#include "heap.h"
+#include "slab.h"
 #include "token.h"
-#include <any>
-#include <map>
+#include "value.h"
+#include <unordered_map>
+#include <vector>
 
 class Environment;
 
-using SPEnvironment = std::shared_ptr<Environment>;
+// 被闭包捕获后可能被重新赋值的变量装箱保存，定义它的环境和捕获它的闭包共享同一个单元
+class Cell : public Obj {
+public:
+  Value value;
+
+  explicit Cell(Value value) : Obj(ObjType::CELL), value(std::move(value)) { Heap::getInstance().track(this); }
+
+  std::string toString() override { return "<cell>"; }
+  void trace(Tracer &tracer) override { ::trace(tracer, value); }
+  void clear() override { value = nullptr; }
+};
 
-class Environment : public std::enable_shared_from_this<Environment> {
+// 环境也是运行时对象，引用归零时回收到空闲池中
+using SPEnvironment = Ref<Environment>;
+
+class Environment : public Obj {
 private:
-  std::map<std::string, std::any> values;
-  int depth = 0;
+  static constexpr std::size_t POOL_MAX = 256;
+
+  // 全局环境按名字保存变量，REPL每一行的代码都能访问；局部环境按resolver分配的槽位保存
+  // unordered_map扩容时元素地址不变，每个全局名字对应一个固定的单元，重复定义时覆盖原单元
+  std::unordered_map<std::string, Value> values;
+  std::vector<Value> slots;
   SPEnvironment enclosing;
 
+  // 没有被闭包捕获的环境在函数返回或块结束时就会回收，保留槽位数组的容量供下一次调用复用
+  static std::vector<Environment *> &pool();
+
+  Environment() : Obj(ObjType::ENVIRONMENT) {}
+
+  void destroy() override;
+
 public:
-  Environment() = default;
-  explicit Environment(SPEnvironment enclosing) : depth(enclosing->depth + 1), enclosing(std::move(enclosing)) {}
-
-  void define(const std::string &name, const std::any &value);
-  std::any get(SPToken name);
-  std::any getAt(int distance, const std::string &name);
-  SPEnvironment ancestor(int distance);
-  void assign(SPToken name, const std::any &value);
-  void assignAt(int distance, const std::string &name, const std::any &value);
+  ~Environment() override = default;
+
+  static SPEnvironment create(SPEnvironment enclosing = nullptr);
+
+  // 对象内存由该类型专用的Slab分配
+  static Slab &allocator();
+  static void *operator new(std::size_t size) { return allocator().allocate(size); }
+  static void operator delete(void *pointer, std::size_t size) { allocator().deallocate(pointer, size); }
+
+  std::string toString() override { return "<environment>"; }
+  void trace(Tracer &tracer) override;
+  void clear() override;
+
+  void define(const std::string &name, const Value &value);
+  Value get(const SPToken &name);
+  void assign(const SPToken &name, const Value &value);
+  // 返回名字对应的单元，变量使用处缓存该指针，之后不再按名字查找
+  Value *cell(const SPToken &name);
+
+  // 局部变量的声明顺序和resolver分配槽位的顺序一致
+  void define(const Value &value) { slots.push_back(value); }
+  std::size_t slotCount() const { return slots.size(); }
+  void truncate(std::size_t count) { slots.resize(count); }
+  void defineAt(int slot, const Value &value);
+  Environment *ancestor(int distance);
+  // 返回槽位本身，被捕获的变量装箱时直接替换槽位中的值
+  Value &getAt(int distance, int slot);
 };
 
 #endif // CLOX_ENVIRONMENT_H
@@ -2,195 +2,283 @@
 #define CLOX_EXPR_H
 
 #include "token.h"
+#include <cstddef>
+#include <stdexcept>
+#include <vector>
+
+// 每种节点一个标记，访问者通过switch分派，不再依次尝试dynamic_pointer_cast
+enum class ExprKind {
+  BINARY,
+  GROUPING,
+  UNARY,
+  LITERAL,
+  VARIABLE,
+  ASSIGN,
+  LOGICAL,
+  CALL,
+  GET,
+  SET,
+  THIS,
+  SUPER,
+};
+
+// resolver对变量引用的解析结果，直接保存在语法树节点上：depth是环境链上的距离，slot是该环境中的槽位
+// 顶层作用域声明的变量保存在全局环境中，只能按名字访问；没有解析到的引用保持UNRESOLVED
+// 当前函数之外的局部变量是UPVALUE，slot是它在闭包捕获列表中的下标
+struct Resolution {
+  static constexpr int GLOBAL = -1;
+  static constexpr int UNRESOLVED = -2;
+  static constexpr int UPVALUE = -3;
+
+  int depth = UNRESOLVED;
+  int slot = 0;
+  // 变量被闭包捕获过，槽位中可能是装箱后的Cell
+  bool boxed = false;
+
+  bool isResolved() const { return depth != UNRESOLVED; }
+  bool isGlobal() const { return depth == GLOBAL; }
+  bool isUpvalue() const { return depth == UPVALUE; }
+};
+
+class Shape;
+class Function;
+
+// 属性访问点的内联缓存：按接收者的Shape和类记录字段槽位，没有该字段时记录类中找到的方法
+// 同一个访问点最多记录WAYS种接收者，再出现新的接收者时轮流覆盖旧的记录
+struct PropertyCache {
+  static constexpr std::size_t WAYS = 4;
+
+  struct Entry {
+    const Shape *shape = nullptr;
+    std::size_t classId = 0;
+    std::size_t slot = 0;
+    Function *method = nullptr;
+  };
+
+  Entry entries[WAYS];
+  std::size_t next = 0;
+
+  Entry *find(const Shape *shape, std::size_t classId) {
+    for (auto &entry : entries) {
+      if (entry.shape == shape && entry.classId == classId) {
+        return &entry;
+      }
+    }
+    return nullptr;
+  }
+
+  Entry *add(const Shape *shape, std::size_t classId) {
+    Entry *entry = &entries[next];
+    next = (next + 1) % WAYS;
+    entry->shape = shape;
+    entry->classId = classId;
+    return entry;
+  }
+};
 
 class Expr {
 public:
+  const ExprKind kind;
+
+  explicit Expr(ExprKind kind) : kind(kind) {}
   virtual ~Expr() = default;
 };
 
-using SPExpr = std::shared_ptr<Expr>;
-
 class BinaryExpr : public Expr {
 public:
-  SPExpr left;
+  Expr *left;
   SPToken op;
-  SPExpr right;
+  Expr *right;
 
   ~BinaryExpr() override = default;
 
-  BinaryExpr(SPExpr left, SPToken op, SPExpr right)
-      : left(std::move(left)), op(std::move(op)), right(std::move(right)) {}
+  BinaryExpr(Expr *left, SPToken op, Expr *right)
+      : Expr(ExprKind::BINARY), left(left), op(std::move(op)), right(right) {}
 };
 
 class GroupingExpr : public Expr {
 public:
-  SPExpr expression;
+  Expr *expression;
 
   ~GroupingExpr() override = default;
 
-  explicit GroupingExpr(SPExpr expression) : expression(std::move(expression)) {}
+  explicit GroupingExpr(Expr *expression) : Expr(ExprKind::GROUPING), expression(expression) {}
 };
 
 class UnaryExpr : public Expr {
 public:
   SPToken op;
-  SPExpr right;
+  Expr *right;
 
   ~UnaryExpr() override = default;
 
-  UnaryExpr(SPToken op, SPExpr right) : op(std::move(op)), right(std::move(right)) {}
+  UnaryExpr(SPToken op, Expr *right) : Expr(ExprKind::UNARY), op(std::move(op)), right(right) {}
 };
 
 class LiteralExpr : public Expr {
 public:
-  std::any value;
+  Value value;
 
   ~LiteralExpr() override = default;
 
-  explicit LiteralExpr(std::any value) : value(std::move(value)) {}
+  explicit LiteralExpr(Value value) : Expr(ExprKind::LITERAL), value(std::move(value)) {}
 };
 
 class VariableExpr : public Expr {
 public:
   SPToken name;
+  Resolution resolution;
+  // 全局变量第一次查找后缓存的单元
+  Value *global = nullptr;
 
   ~VariableExpr() override = default;
 
-  explicit VariableExpr(SPToken name) : name(std::move(name)) {}
+  explicit VariableExpr(SPToken name) : Expr(ExprKind::VARIABLE), name(std::move(name)) {}
 };
 
 class AssignExpr : public Expr {
 public:
   SPToken name;
-  SPExpr value;
+  Expr *value;
   bool returnOriginal;
+  Resolution resolution;
+  Value *global = nullptr;
 
   ~AssignExpr() override = default;
 
-  AssignExpr(SPToken name, SPExpr value, bool returnOriginal)
-      : name(std::move(name)), value(std::move(value)), returnOriginal(returnOriginal) {}
+  AssignExpr(SPToken name, Expr *value, bool returnOriginal)
+      : Expr(ExprKind::ASSIGN), name(std::move(name)), value(value), returnOriginal(returnOriginal) {}
 };
 
 class LogicalExpr : public Expr {
 public:
-  SPExpr left;
+  Expr *left;
   SPToken op;
-  SPExpr right;
+  Expr *right;
 
   ~LogicalExpr() override = default;
 
-  LogicalExpr(SPExpr left, SPToken op, SPExpr right)
-      : left(std::move(left)), op(std::move(op)), right(std::move(right)) {}
+  LogicalExpr(Expr *left, SPToken op, Expr *right)
+      : Expr(ExprKind::LOGICAL), left(left), op(std::move(op)), right(right) {}
 };
 
 class CallExpr : public Expr {
 public:
-  SPExpr callee;
+  Expr *callee;
   SPToken paren;
-  std::vector<SPExpr> arguments;
+  std::vector<Expr *> arguments;
 
   ~CallExpr() override = default;
 
-  CallExpr(SPExpr callee, SPToken paren, std::vector<SPExpr> arguments)
-      : callee(std::move(callee)), paren(std::move(paren)), arguments(std::move(arguments)) {}
+  CallExpr(Expr *callee, SPToken paren, std::vector<Expr *> arguments)
+      : Expr(ExprKind::CALL), callee(callee), paren(std::move(paren)), arguments(std::move(arguments)) {}
 };
 
 class GetExpr : public Expr {
 public:
-  SPExpr object;
+  Expr *object;
   SPToken name;
+  PropertyCache cache;
 
   ~GetExpr() override = default;
 
-  GetExpr(SPExpr object, SPToken name) : object(std::move(object)), name(std::move(name)) {}
+  GetExpr(Expr *object, SPToken name) : Expr(ExprKind::GET), object(object), name(std::move(name)) {}
 };
 
 class SetExpr : public Expr {
 public:
-  SPExpr object;
+  Expr *object;
   SPToken name;
-  SPExpr value;
+  Expr *value;
   bool returnOriginal;
+  PropertyCache cache;
 
   ~SetExpr() override = default;
 
-  SetExpr(SPExpr object, SPToken name, SPExpr value, bool returnOriginal)
-      : object(std::move(object)), name(std::move(name)), value(std::move(value)), returnOriginal(returnOriginal) {}
+  SetExpr(Expr *object, SPToken name, Expr *value, bool returnOriginal)
+      : Expr(ExprKind::SET), object(object), name(std::move(name)), value(value), returnOriginal(returnOriginal) {}
 };
 
 class ThisExpr : public Expr {
 public:
   SPToken keyword;
+  Resolution resolution;
 
   ~ThisExpr() override = default;
 
-  explicit ThisExpr(SPToken keyword) : keyword(std::move(keyword)) {}
+  explicit ThisExpr(SPToken keyword) : Expr(ExprKind::THIS), keyword(std::move(keyword)) {}
 };
 
 class SuperExpr : public Expr {
 public:
   SPToken keyword;
   SPToken method;
+  Resolution resolution;
+  // super方法绑定的this
+  Resolution thisResolution;
 
   ~SuperExpr() override = default;
 
-  SuperExpr(SPToken keyword, SPToken method) : keyword(std::move(keyword)), method(std::move(method)) {}
+  SuperExpr(SPToken keyword, SPToken method)
+      : Expr(ExprKind::SUPER), keyword(std::move(keyword)), method(std::move(method)) {}
 };
 
 template <typename R> class ExprVisitor {
 protected:
-  R visitExpr(SPExpr expr) {
-    if (auto p = std::dynamic_pointer_cast<BinaryExpr>(expr)) {
-      return visitBinaryExpr(p);
-    }
-    if (auto p = std::dynamic_pointer_cast<GroupingExpr>(expr)) {
-      return visitGroupingExpr(p);
-    }
-    if (auto p = std::dynamic_pointer_cast<UnaryExpr>(expr)) {
-      return visitUnaryExpr(p);
-    }
-    if (auto p = std::dynamic_pointer_cast<LiteralExpr>(expr)) {
-      return visitLiteralExpr(p);
-    }
-    if (auto p = std::dynamic_pointer_cast<VariableExpr>(expr)) {
-      return visitVariableExpr(p);
-    }
-    if (auto p = std::dynamic_pointer_cast<AssignExpr>(expr)) {
-      return visitAssignExpr(p);
-    }
-    if (auto p = std::dynamic_pointer_cast<LogicalExpr>(expr)) {
-      return visitLogicalExpr(p);
-    }
-    if (auto p = std::dynamic_pointer_cast<CallExpr>(expr)) {
-      return visitCallExpr(p);
-    }
-    if (auto p = std::dynamic_pointer_cast<GetExpr>(expr)) {
-      return visitGetExpr(p);
-    }
-    if (auto p = std::dynamic_pointer_cast<SetExpr>(expr)) {
-      return visitSetExpr(p);
-    }
-    if (auto p = std::dynamic_pointer_cast<ThisExpr>(expr)) {
-      return visitThisExpr(p);
-    }
-    if (auto p = std::dynamic_pointer_cast<SuperExpr>(expr)) {
-      return visitSuperExpr(p);
+  R visitExpr(Expr *expr) {
+    switch (expr->kind) {
+      case ExprKind::BINARY: {
+        return visitBinaryExpr(static_cast<BinaryExpr *>(expr));
+      }
+      case ExprKind::GROUPING: {
+        return visitGroupingExpr(static_cast<GroupingExpr *>(expr));
+      }
+      case ExprKind::UNARY: {
+        return visitUnaryExpr(static_cast<UnaryExpr *>(expr));
+      }
+      case ExprKind::LITERAL: {
+        return visitLiteralExpr(static_cast<LiteralExpr *>(expr));
+      }
+      case ExprKind::VARIABLE: {
+        return visitVariableExpr(static_cast<VariableExpr *>(expr));
+      }
+      case ExprKind::ASSIGN: {
+        return visitAssignExpr(static_cast<AssignExpr *>(expr));
+      }
+      case ExprKind::LOGICAL: {
+        return visitLogicalExpr(static_cast<LogicalExpr *>(expr));
+      }
+      case ExprKind::CALL: {
+        return visitCallExpr(static_cast<CallExpr *>(expr));
+      }
+      case ExprKind::GET: {
+        return visitGetExpr(static_cast<GetExpr *>(expr));
+      }
+      case ExprKind::SET: {
+        return visitSetExpr(static_cast<SetExpr *>(expr));
+      }
+      case ExprKind::THIS: {
+        return visitThisExpr(static_cast<ThisExpr *>(expr));
+      }
+      case ExprKind::SUPER: {
+        return visitSuperExpr(static_cast<SuperExpr *>(expr));
+      }
     }
     throw std::runtime_error("Unexpected expression type.");
   }
 
-  virtual R visitBinaryExpr(std::shared_ptr<BinaryExpr> expr) = 0;
-  virtual R visitGroupingExpr(std::shared_ptr<GroupingExpr> expr) = 0;
-  virtual R visitUnaryExpr(std::shared_ptr<UnaryExpr> expr) = 0;
-  virtual R visitLiteralExpr(std::shared_ptr<LiteralExpr> expr) = 0;
-  virtual R visitVariableExpr(std::shared_ptr<VariableExpr> expr) = 0;
-  virtual R visitAssignExpr(std::shared_ptr<AssignExpr> expr) = 0;
-  virtual R visitLogicalExpr(std::shared_ptr<LogicalExpr> expr) = 0;
-  virtual R visitCallExpr(std::shared_ptr<CallExpr> expr) = 0;
-  virtual R visitGetExpr(std::shared_ptr<GetExpr> expr) = 0;
-  virtual R visitSetExpr(std::shared_ptr<SetExpr> expr) = 0;
-  virtual R visitThisExpr(std::shared_ptr<ThisExpr> expr) = 0;
-  virtual R visitSuperExpr(std::shared_ptr<SuperExpr> expr) = 0;
+  virtual R visitBinaryExpr(BinaryExpr *expr) = 0;
+  virtual R visitGroupingExpr(GroupingExpr *expr) = 0;
+  virtual R visitUnaryExpr(UnaryExpr *expr) = 0;
+  virtual R visitLiteralExpr(LiteralExpr *expr) = 0;
+  virtual R visitVariableExpr(VariableExpr *expr) = 0;
+  virtual R visitAssignExpr(AssignExpr *expr) = 0;
+  virtual R visitLogicalExpr(LogicalExpr *expr) = 0;
+  virtual R visitCallExpr(CallExpr *expr) = 0;
+  virtual R visitGetExpr(GetExpr *expr) = 0;
+  virtual R visitSetExpr(SetExpr *expr) = 0;
+  virtual R visitThisExpr(ThisExpr *expr) = 0;
+  virtual R visitSuperExpr(SuperExpr *expr) = 0;
 };
 
 #endif // CLOX_EXPR_H
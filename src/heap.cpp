@@ -0,0 +1,214 @@
+#include "heap.h"
+#include <algorithm>
+#include <utility>
+#include <vector>
+
+Obj::~Obj() {
+  if (tracked) {
+    Heap::getInstance().untrack(this);
+  }
+}
+
+void Heap::track(Obj *obj) {
+  obj->tracked = true;
+  link(obj, YOUNG);
+}
+
+void Heap::untrack(Obj *obj) {
+  if (!obj->tracked) {
+    return;
+  }
+  unlink(obj);
+  obj->tracked = false;
+}
+
+void Heap::link(Obj *obj, std::uint8_t space) {
+  obj->generation = space;
+  obj->prev = nullptr;
+  obj->next = objects[space];
+  if (objects[space]) {
+    objects[space]->prev = obj;
+  } else {
+    tails[space] = obj;
+  }
+  objects[space] = obj;
+  counts[space]++;
+}
+
+void Heap::unlink(Obj *obj) {
+  if (obj->prev) {
+    obj->prev->next = obj->next;
+  } else {
+    objects[obj->generation] = obj->next;
+  }
+  if (obj->next) {
+    obj->next->prev = obj->prev;
+  } else {
+    tails[obj->generation] = obj->prev;
+  }
+  obj->prev = nullptr;
+  obj->next = nullptr;
+  counts[obj->generation]--;
+}
+
+// 把from整个接到to的头部，只遍历from
+void Heap::splice(std::uint8_t from, std::uint8_t to) {
+  if (!objects[from]) {
+    return;
+  }
+  for (Obj *obj = objects[from]; obj; obj = obj->next) {
+    obj->generation = to;
+  }
+  tails[from]->next = objects[to];
+  if (objects[to]) {
+    objects[to]->prev = tails[from];
+  } else {
+    tails[to] = tails[from];
+  }
+  objects[to] = objects[from];
+  counts[to] += counts[from];
+  objects[from] = nullptr;
+  tails[from] = nullptr;
+  counts[from] = 0;
+}
+
+std::size_t Heap::collectYoung() {
+  std::size_t garbage = sweep(YOUNG);
+  // 一轮进行中时晋升的对象放在待处理对象最新的一端，本轮最后处理，保持从老到新的顺序
+  splice(YOUNG, sweeping ? pending : scanned);
+  collections++;
+  return garbage;
+}
+
+std::size_t Heap::collectSlice() {
+  if (!sweeping) {
+    std::swap(pending, scanned);
+    sweeping = true;
+  }
+
+  // 对象大多引用比自己老的对象，从最老的一端取起，补进来的可达对象通常很少
+  struct Gather : Tracer {
+    Heap &heap;
+    std::vector<Obj *> stack;
+
+    explicit Gather(Heap &heap) : heap(heap) {}
+
+    void visit(Obj *obj) override {
+      if (obj->tracked && obj->generation == heap.pending) {
+        heap.unlink(obj);
+        heap.link(obj, SLICE);
+        stack.push_back(obj);
+      }
+    }
+  } gather(*this);
+
+  while (counts[SLICE] < sliceSize && tails[pending]) {
+    gather.visit(tails[pending]);
+    while (!gather.stack.empty()) {
+      Obj *obj = gather.stack.back();
+      gather.stack.pop_back();
+      obj->trace(gather);
+    }
+  }
+
+  std::size_t garbage = sweep(SLICE);
+  splice(SLICE, scanned);
+  // 待处理的对象也可能被引用计数释放，所以在这里判断一轮是否结束
+  if (counts[pending] == 0) {
+    sweeping = false;
+    updateThreshold();
+  }
+  collections++;
+  return garbage;
+}
+
+std::size_t Heap::collect() {
+  splice(YOUNG, scanned);
+  splice(pending, scanned);
+  sweeping = false;
+  std::size_t garbage = sweep(scanned);
+  updateThreshold();
+  collections++;
+  return garbage;
+}
+
+void Heap::updateThreshold() {
+  threshold = std::max(MIN_THRESHOLD, static_cast<std::size_t>(static_cast<double>(counts[scanned]) * growthFactor));
+}
+
+std::size_t Heap::sweep(std::uint8_t generation) {
+  // 引用计数减去本组对象之间的引用，剩下的引用来自全局环境、当前环境链、C++栈上的Ref和组外的对象，这些对象就是根
+  // 组外的对象不参与这次回收，它们持有的引用自然留在计数里，所以不需要写屏障
+  struct Subtract : Tracer {
+    std::uint8_t generation;
+
+    explicit Subtract(std::uint8_t generation) : generation(generation) {}
+
+    void visit(Obj *obj) override {
+      if (obj->tracked && obj->generation == generation) {
+        obj->gcRefs--;
+      }
+    }
+  } subtract(generation);
+
+  for (Obj *obj = objects[generation]; obj; obj = obj->next) {
+    obj->gcRefs = obj->refCount;
+    obj->marked = false;
+  }
+  for (Obj *obj = objects[generation]; obj; obj = obj->next) {
+    obj->trace(subtract);
+  }
+
+  struct Mark : Tracer {
+    std::uint8_t generation;
+    std::vector<Obj *> gray;
+
+    explicit Mark(std::uint8_t generation) : generation(generation) {}
+
+    void visit(Obj *obj) override {
+      if (obj->tracked && obj->generation == generation && !obj->marked) {
+        obj->marked = true;
+        gray.push_back(obj);
+      }
+    }
+  } mark(generation);
+
+  for (Obj *obj = objects[generation]; obj; obj = obj->next) {
+    if (obj->gcRefs > 0) {
+      mark.visit(obj);
+    }
+  }
+  while (!mark.gray.empty()) {
+    Obj *obj = mark.gray.back();
+    mark.gray.pop_back();
+    obj->trace(mark);
+  }
+
+  // 先持有所有垃圾再断开引用，避免断开过程中释放还没处理的对象
+  std::vector<Obj *> garbage;
+  for (Obj *obj = objects[generation]; obj; obj = obj->next) {
+    if (!obj->marked) {
+      obj->retain();
+      garbage.push_back(obj);
+    }
+  }
+  for (Obj *obj : garbage) {
+    obj->clear();
+  }
+  for (Obj *obj : garbage) {
+    obj->release();
+  }
+
+  return garbage.size();
+}
+
+void Heap::setNurserySize(std::size_t size) { nurserySize = std::max<std::size_t>(size, 1); }
+
+void Heap::setSliceSize(std::size_t size) { sliceSize = std::max<std::size_t>(size, 1); }
+
+void Heap::setGrowthFactor(double factor) { growthFactor = std::max(factor, 1.0); }
+
+Heap &Heap::getInstance() {
+  static Heap instance;
+  return instance;
+}
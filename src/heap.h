@@ -0,0 +1,83 @@
+#ifndef CLOX_HEAP_H
+#define CLOX_HEAP_H
+
+#include "value.h"
+#include <cstddef>
+#include <cstdint>
+
+// 托管堆：登记解释器和虚拟机中可能形成引用环的对象（环境、函数、类、实例、Cell、闭包、upvalue、绑定方法）
+// 对象平时仍然由引用计数及时释放；登记的对象数量超过阈值时做一次标记清除，回收引用计数处理不了的环
+// 新对象先进入新生代，新生代满了只回收新生代，停顿时间和新生代大小成正比；存活下来的对象晋升到老年代
+// 老年代超过阈值后开始一轮分片回收，之后每次新生代回收顺带处理一片老年代对象，直到这一轮处理完所有老对象
+// 一片从最老的待处理对象取起，取够预算为止，每个对象能到达的待处理对象也一起放进这一片，保证垃圾环不会被切开
+// 所以一片的大小是预算加上最后取的对象能到达的待处理对象：由旧对象指向新对象的长链表这类巨大结构仍会在一片中处理完，
+// 这种情况下老年代的停顿没有上界；collect()做完整回收，停顿和整个堆的大小成正比
+class Heap {
+private:
+  static constexpr std::size_t MIN_THRESHOLD = 1024;
+  static constexpr std::uint8_t YOUNG = 0;
+  static constexpr std::uint8_t SLICE = 3; // 正在处理的一片
+
+  // 老年代分成本轮还没处理和已经处理过的两个空间，一轮开始时交换两者的角色；不在回收中时所有老对象都在scanned
+  std::uint8_t pending = 1;
+  std::uint8_t scanned = 2;
+  bool sweeping = false; // 是否有进行中的一轮
+
+  Obj *objects[4] = {nullptr, nullptr, nullptr, nullptr};
+  Obj *tails[4] = {nullptr, nullptr, nullptr, nullptr};
+  std::size_t counts[4] = {0, 0, 0, 0};
+  std::size_t nurserySize = MIN_THRESHOLD;
+  std::size_t sliceSize = 4 * MIN_THRESHOLD;
+  std::size_t threshold = MIN_THRESHOLD;
+  double growthFactor = 2.0;
+  std::size_t collections = 0;
+
+  Heap() = default;
+
+  void link(Obj *obj, std::uint8_t space);
+  void unlink(Obj *obj);
+  void splice(std::uint8_t from, std::uint8_t to);
+  std::size_t sweep(std::uint8_t generation);
+  void updateThreshold();
+
+public:
+  static Heap &getInstance();
+  Heap(const Heap &) = delete;
+  Heap &operator=(const Heap &) = delete;
+
+  void track(Obj *obj);
+  // 之后只靠引用计数释放，重复调用没有影响
+  void untrack(Obj *obj);
+
+  // 只能在没有构造到一半的对象时调用，比如函数调用前和循环的两次迭代之间
+  void collectIfNeeded() {
+    if (counts[YOUNG] > nurserySize) {
+      collectYoung();
+      if (sweeping || counts[scanned] > threshold) {
+        collectSlice();
+      }
+    }
+  }
+  // 只回收新生代，老年代对新生代的引用都算作根
+  std::size_t collectYoung();
+  // 处理老年代的一片，没有进行中的一轮时开始新的一轮；这一片以外对它的引用都算作根
+  std::size_t collectSlice();
+  // 回收整个堆
+  std::size_t collect();
+
+  // 新生代的容量，决定一次新生代回收最多处理多少对象
+  void setNurserySize(std::size_t size);
+  // 每片老年代回收至少取多少对象，实际数量还要加上它们能到达的待处理对象
+  // 应当大于新生代的容量，否则新晋升的对象追上处理进度，一轮回收结束不了
+  void setSliceSize(std::size_t size);
+  // 每轮老年代回收后，下一轮开始的阈值为存活对象数量乘以该系数
+  void setGrowthFactor(double factor);
+
+  std::size_t objectCount() const { return counts[YOUNG] + counts[pending] + counts[scanned] + counts[SLICE]; }
+  std::size_t youngCount() const { return counts[YOUNG]; }
+  // 是否有进行中的一轮老年代回收
+  bool isSweeping() const { return sweeping; }
+  std::size_t collectionCount() const { return collections; }
+};
+
+#endif // CLOX_HEAP_H
@@ -7,75 +7,77 @@
 
 using namespace util;
 
-void Interpreter::reset() { locals.clear(); }
-
 Interpreter::Interpreter() {
-  globals->define("clock", static_cast<SPCallable>(std::make_shared<Clock>()));
-  globals->define("count", static_cast<SPCallable>(std::make_shared<Count>()));
+  // 全局环境和解释器一样一直存活，不登记到Heap，它引用的对象都算作根；
+  // 否则几乎所有对象都能经由类和函数的闭包到达它，分片回收会把整个堆拉进同一片
+  Heap::getInstance().untrack(globals.get());
+
+  globals->define("clock", SPCallable(makeRef<Clock>()));
+  globals->define("count", SPCallable(makeRef<Count>()));
 }
 
-std::any Interpreter::evaluate(SPExpr expr) { return visitExpr(std::move(expr)); }
+Value Interpreter::evaluate(Expr *expr) { return visitExpr(expr); }
 
-void Interpreter::checkNumberOperand(SPToken op, std::any &value) {
-  if (isNumber(value)) {
+void Interpreter::checkNumberOperand(const SPToken &op, const Value &value) {
+  if (value.isNumber()) {
     return;
   }
-  throw error(std::move(op), "Operand must be a number.");
+  throw error(op, "Operand must be a number.");
 }
 
-void Interpreter::checkNumberOperands(SPToken op, std::any &left, std::any &right) {
-  if (isNumber(left) && isNumber(right)) {
+void Interpreter::checkNumberOperands(const SPToken &op, const Value &left, const Value &right) {
+  if (left.isNumber() && right.isNumber()) {
     return;
   }
-  throw error(std::move(op), "Operands must be two numbers.");
+  throw error(op, "Operands must be two numbers.");
 }
 
-std::any Interpreter::visitBinaryExpr(std::shared_ptr<BinaryExpr> expr) {
-  std::any left = evaluate(expr->left);
-  std::any right = evaluate(expr->right);
+Value Interpreter::visitBinaryExpr(BinaryExpr *expr) {
+  Value left = evaluate(expr->left);
+  Value right = evaluate(expr->right);
 
   switch (expr->op->type) {
     case TokenType::MINUS: {
       checkNumberOperands(expr->op, left, right);
-      return toNumber(left, 0) - toNumber(right, 0);
+      return left.asNumber() - right.asNumber();
     }
     case TokenType::SLASH: {
       checkNumberOperands(expr->op, left, right);
-      double rightValue = toNumber(right, 0);
+      double rightValue = right.asNumber();
       if (rightValue == 0) {
         throw error(expr->op, "Division by zero"); // ZeroDivisionError
       }
-      return toNumber(left, 0) / rightValue;
+      return left.asNumber() / rightValue;
     }
     case TokenType::STAR: {
       checkNumberOperands(expr->op, left, right);
-      return toNumber(left, 0) * toNumber(right, 0);
+      return left.asNumber() * right.asNumber();
     }
     case TokenType::PLUS: {
-      if (isNumber(left) && isNumber(right)) {
-        return toNumber(left, 0) + toNumber(right, 0);
+      if (left.isNumber() && right.isNumber()) {
+        return left.asNumber() + right.asNumber();
       }
       // 支持字符串拼接
-      if (isString(left) && isString(right)) {
-        return toString(left, "") + toString(right, "");
+      if (left.isString() && right.isString()) {
+        return left.asString() + right.asString();
       }
       throw error(expr->op, "Operands must be two numbers or two strings.");
     }
     case TokenType::GREATER: {
       checkNumberOperands(expr->op, left, right);
-      return toNumber(left, 0) > toNumber(right, 0);
+      return left.asNumber() > right.asNumber();
     }
     case TokenType::GREATER_EQUAL: {
       checkNumberOperands(expr->op, left, right);
-      return toNumber(left, 0) >= toNumber(right, 0);
+      return left.asNumber() >= right.asNumber();
     }
     case TokenType::LESS: {
       checkNumberOperands(expr->op, left, right);
-      return toNumber(left, 0) < toNumber(right, 0);
+      return left.asNumber() < right.asNumber();
     }
     case TokenType::LESS_EQUAL: {
       checkNumberOperands(expr->op, left, right);
-      return toNumber(left, 0) <= toNumber(right, 0);
+      return left.asNumber() <= right.asNumber();
     }
     case TokenType::BANG_EQUAL: {
       return !isEqual(left, right);
@@ -85,7 +87,7 @@ std::any Interpreter::visitBinaryExpr(std::shared_ptr<BinaryExpr> expr) {
     }
     case TokenType::STAR_STAR: {
       checkNumberOperands(expr->op, left, right);
-      return pow(toNumber(left, 0), toNumber(right, 0));
+      return pow(left.asNumber(), right.asNumber());
     }
     default: {
     }
@@ -94,10 +96,10 @@ std::any Interpreter::visitBinaryExpr(std::shared_ptr<BinaryExpr> expr) {
   throw error(expr->op, "Unexpected operator type.");
 }
 
-std::any Interpreter::visitGroupingExpr(std::shared_ptr<GroupingExpr> expr) { return evaluate(expr->expression); }
+Value Interpreter::visitGroupingExpr(GroupingExpr *expr) { return evaluate(expr->expression); }
 
-std::any Interpreter::visitUnaryExpr(std::shared_ptr<UnaryExpr> expr) {
-  std::any right = evaluate(expr->right);
+Value Interpreter::visitUnaryExpr(UnaryExpr *expr) {
+  Value right = evaluate(expr->right);
 
   switch (expr->op->type) {
     case TokenType::BANG: {
@@ -105,11 +107,11 @@ std::any Interpreter::visitUnaryExpr(std::shared_ptr<UnaryExpr> expr) {
     }
     case TokenType::PLUS: {
       checkNumberOperand(expr->op, right);
-      return toNumber(right, 0);
+      return right.asNumber();
     }
     case TokenType::MINUS: {
       checkNumberOperand(expr->op, right);
-      return -toNumber(right, 0);
+      return -right.asNumber();
     }
     default: {
     }
@@ -118,35 +120,39 @@ std::any Interpreter::visitUnaryExpr(std::shared_ptr<UnaryExpr> expr) {
   throw error(expr->op, "Unexpected operator type.");
 }
 
-std::any Interpreter::visitLiteralExpr(std::shared_ptr<LiteralExpr> expr) { return (expr->value); }
+Value Interpreter::visitLiteralExpr(LiteralExpr *expr) { return (expr->value); }
 
-std::any Interpreter::visitVariableExpr(std::shared_ptr<VariableExpr> expr) {
-  auto it = locals.find(expr);
-  if (it != locals.end()) {
-    return environment->getAt(it->second, expr->name->lexeme);
+Value Interpreter::visitVariableExpr(VariableExpr *expr) {
+  const Resolution &resolution = expr->resolution;
+  if (resolution.isResolved() && !resolution.isGlobal()) {
+    return lookUp(resolution);
   } else {
     // 需要获取系统内置函数
-    return globals->get(expr->name);
+    return *globalCell(expr->name, expr->global);
   }
 }
 
-std::any Interpreter::visitAssignExpr(std::shared_ptr<AssignExpr> expr) {
-  std::any original;
-  std::any value = evaluate(expr->value);
+Value Interpreter::visitAssignExpr(AssignExpr *expr) {
+  Value original;
+  Value value = evaluate(expr->value);
 
-  auto it = locals.find(expr);
-  if (it != locals.end()) {
-    original = environment->getAt(it->second, expr->name->lexeme);
-    environment->assignAt(it->second, expr->name->lexeme, value);
-  } else {
+  const Resolution &resolution = expr->resolution;
+  if (!resolution.isResolved()) {
     throw error(expr->name, "This variable can't be found.");
+  } else if (resolution.isGlobal()) {
+    Value *cell = globalCell(expr->name, expr->global);
+    original = *cell;
+    *cell = value;
+  } else {
+    original = lookUp(resolution);
+    assignLocal(resolution, value);
   }
 
   return expr->returnOriginal ? std::move(original) : std::move(value);
 }
 
-std::any Interpreter::visitLogicalExpr(std::shared_ptr<LogicalExpr> expr) {
-  std::any left = evaluate(expr->left);
+Value Interpreter::visitLogicalExpr(LogicalExpr *expr) {
+  Value left = evaluate(expr->left);
 
   // or/and
   if (expr->op->type == TokenType::OR) {
@@ -162,113 +168,235 @@ std::any Interpreter::visitLogicalExpr(std::shared_ptr<LogicalExpr> expr) {
   return evaluate(expr->right);
 }
 
-template <typename T>
-std::any Interpreter::handleCall(std::shared_ptr<CallExpr> expr, std::any callee, std::vector<std::any> &arguments) {
-  auto callable = std::any_cast<T>(callee);
+Value Interpreter::visitCallExpr(CallExpr *expr) {
+  Value callee;
+  Value receiver;
+  Function *function = nullptr;
+
+  // obj.method(args)直接把obj作为接收者调用方法，不创建bind之后的函数对象
+  if (expr->callee->kind == ExprKind::GET) {
+    auto getExpr = static_cast<GetExpr *>(expr->callee);
+    Value object = evaluate(getExpr->object);
+    if (object.isInstance()) {
+      function = object.as<Instance>()->method(getExpr->name, getExpr->cache);
+    }
+    if (function) {
+      receiver = std::move(object);
+    } else {
+      callee = property(getExpr, object);
+    }
+  } else {
+    callee = evaluate(expr->callee);
+  }
 
-  if (arguments.size() != callable->arity()) {
-    throw error(expr->paren, "Expected " + toString(static_cast<int>(callable->arity()), "") + " arguments but got " +
-                                 toString(static_cast<int>(arguments.size()), "") + "."); // std::size_t => int
+  if (!function && callee.isObjType(ObjType::FUNCTION)) {
+    function = callee.as<Function>();
+    receiver = function->receiver;
   }
 
-  return callable->call(this, arguments);
-}
+  // 用户函数的参数直接求值到新环境的槽位中，不经过临时的参数数组
+  if (function) {
+    SPEnvironment environment = function->frame(receiver);
+    for (auto &argument : expr->arguments) {
+      environment->define(evaluate(argument));
+    }
+    checkArity(expr->paren, function->arity(), expr->arguments.size());
+
+    // 调用前所有临时对象都由Ref持有，可以安全地回收
+    Heap::getInstance().collectIfNeeded();
 
-std::any Interpreter::visitCallExpr(std::shared_ptr<CallExpr> expr) {
-  std::any callee = evaluate(expr->callee);
+    return function->run(this, environment);
+  }
 
-  std::vector<std::any> arguments;
+  std::vector<Value> arguments;
   arguments.reserve(expr->arguments.size());
 
   for (auto &argument : expr->arguments) {
     arguments.push_back(evaluate(argument));
   }
 
-  if (callee.type() == typeid(SPCallable)) {
-    return handleCall<SPCallable>(expr, callee, arguments);
+  if (!callee.isCallable()) {
+    throw error(expr->paren, "Can only call functions and classes.");
   }
 
-  if (callee.type() == typeid(SPClass)) {
-    return handleCall<SPClass>(expr, callee, arguments);
-  }
+  auto callable = callee.asRef<Callable>();
+  checkArity(expr->paren, callable->arity(), arguments.size());
+
+  Heap::getInstance().collectIfNeeded();
 
-  throw error(expr->paren, "Can only call functions and classes.");
+  return callable->call(this, arguments);
+}
+
+void Interpreter::checkArity(const SPToken &paren, std::size_t arity, std::size_t count) {
+  if (count != arity) {
+    throw error(paren, "Expected " + toString(static_cast<int>(arity), "") + " arguments but got " +
+                           toString(static_cast<int>(count), "") + "."); // std::size_t => int
+  }
 }
 
-std::any Interpreter::visitGetExpr(std::shared_ptr<GetExpr> expr) {
-  std::any object = evaluate(expr->object);
+Value Interpreter::visitGetExpr(GetExpr *expr) { return property(expr, evaluate(expr->object)); }
 
-  if (object.type() == typeid(SPClass)) {
-    return std::any_cast<SPClass>(object)->get(expr->name);
+Value Interpreter::property(GetExpr *expr, const Value &object) {
+  if (object.isClass()) {
+    return object.as<Class>()->get(expr->name);
   }
 
-  if (object.type() == typeid(SPInstance)) {
-    return std::any_cast<SPInstance>(object)->get(expr->name);
+  if (object.isInstance()) {
+    return object.as<Instance>()->get(expr->name, expr->cache);
   }
 
   throw error(expr->name, "Only instances have properties.");
 }
 
-template <typename T> std::any setValue(std::shared_ptr<SetExpr> expr, std::any object, std::any value) {
-  auto obj = std::any_cast<T>(object);
+template <typename T> Value setValue(SetExpr *expr, const Value &object, Value value) {
+  auto obj = object.as<T>();
   auto original = obj->get(expr->name);
   obj->assign(expr->name, value);
   return expr->returnOriginal ? std::move(original) : std::move(value);
 }
 
-std::any Interpreter::visitSetExpr(std::shared_ptr<SetExpr> expr) {
-  std::any object = evaluate(expr->object);
-  std::any value = evaluate(expr->value);
+Value Interpreter::visitSetExpr(SetExpr *expr) {
+  Value object = evaluate(expr->object);
+  Value value = evaluate(expr->value);
 
-  if (object.type() == typeid(SPClass)) {
-    return setValue<SPClass>(expr, object, value);
+  if (object.isClass()) {
+    return setValue<Class>(expr, object, value);
   }
 
-  if (object.type() == typeid(SPInstance)) {
-    return setValue<SPInstance>(expr, object, value);
+  if (object.isInstance()) {
+    auto instance = object.as<Instance>();
+    auto original = instance->get(expr->name, expr->cache);
+    instance->set(expr->name, value, expr->cache);
+    return expr->returnOriginal ? std::move(original) : std::move(value);
   }
 
   throw error(expr->name, "Only instances have properties.");
 }
 
-std::any Interpreter::visitThisExpr(std::shared_ptr<ThisExpr> expr) {
-  auto it = locals.find(expr);
-  if (it != locals.end()) {
-    return environment->getAt(it->second, expr->keyword->lexeme);
+Value Interpreter::visitThisExpr(ThisExpr *expr) {
+  const Resolution &resolution = expr->resolution;
+  if (resolution.isResolved()) {
+    return lookUp(resolution);
   } else {
     throw error(expr->keyword, "Can't find binding.");
   }
 }
 
-std::any Interpreter::visitSuperExpr(std::shared_ptr<SuperExpr> expr) {
-  auto it = locals.find(expr);
-  if (it != locals.end()) {
-    auto r1 = environment->getAt(it->second, expr->keyword->lexeme); // "super"
-    if (r1.type() != typeid(SPClass)) {
+Value Interpreter::visitSuperExpr(SuperExpr *expr) {
+  const Resolution &resolution = expr->resolution;
+  if (resolution.isResolved()) {
+    auto r1 = lookUp(resolution); // "super"
+    if (!r1.isClass()) {
       throw error(expr->keyword, "Unknown error");
     }
-    auto superclass = std::any_cast<SPClass>(r1);
+    auto superclass = r1.asRef<Class>();
 
-    auto r2 = environment->getAt(it->second - 1, "this"); // 直接从更近的env获取this定义
-    if (r2.type() != typeid(SPInstance)) {
+    auto r2 = lookUp(expr->thisResolution);
+    if (!r2.isInstance()) {
       throw error(expr->keyword, "Unknown error");
     }
-    auto instance = std::any_cast<SPInstance>(r2);
+    auto instance = r2.asRef<Instance>();
 
     SPFunction method = superclass->findMethod(expr->method->lexeme);
     if (!method) {
-      throw error(expr->method, "Undefined property '" + expr->method->lexeme + "'.");
+      throw error(expr->method, "Undefined property '" + std::string(expr->method->lexeme) + "'.");
     }
 
-    return static_cast<SPCallable>(method->bind(instance));
+    return method->bind(instance);
   } else {
     throw error(expr->keyword, "Can't find binding.");
   }
 }
 
-void Interpreter::execute(SPStmt stmt) { visitStmt(std::move(stmt)); }
+Completion Interpreter::execute(Stmt *stmt) { return visitStmt(stmt); }
+
+std::size_t Interpreter::reserve() {
+  std::size_t slot = environment->slotCount();
+  if (environment != globals) {
+    environment->define(nullptr);
+  }
+  return slot;
+}
+
+void Interpreter::initialize(const SPToken &name, std::size_t slot, const Value &value) {
+  if (environment == globals) {
+    globals->define(std::string(name->lexeme), value);
+    return;
+  }
+
+  Value &target = environment->getAt(0, static_cast<int>(slot));
+  if (target.isObjType(ObjType::CELL)) {
+    target.as<Cell>()->value = value;
+  } else {
+    target = value;
+  }
+}
+
+Value Interpreter::lookUp(const Resolution &resolution) {
+  if (resolution.isUpvalue()) {
+    const Value &value = captures->at(resolution.slot);
+    return value.isObjType(ObjType::CELL) ? value.as<Cell>()->value : value;
+  }
+
+  const Value &value = environment->getAt(resolution.depth, resolution.slot);
+  if (resolution.boxed && value.isObjType(ObjType::CELL)) {
+    return value.as<Cell>()->value;
+  }
+  return value;
+}
+
+void Interpreter::assignLocal(const Resolution &resolution, const Value &value) {
+  if (resolution.isUpvalue()) {
+    captures->at(resolution.slot).as<Cell>()->value = value;
+    return;
+  }
+
+  Value &target = environment->getAt(resolution.depth, resolution.slot);
+  if (resolution.boxed && target.isObjType(ObjType::CELL)) {
+    target.as<Cell>()->value = value;
+  } else {
+    target = value;
+  }
+}
+
+std::vector<Value> Interpreter::capture(const std::vector<Capture> &specs, const std::vector<Value> *enclosing) {
+  std::vector<Value> values;
+  values.reserve(specs.size());
+
+  for (auto &spec : specs) {
+    if (!spec.isLocal) {
+      values.push_back(enclosing->at(spec.index));
+      continue;
+    }
+
+    // 第一次被捕获时装箱，之后定义它的环境和所有闭包都通过同一个Cell读写
+    Value &slot = environment->getAt(spec.depth, spec.index);
+    if (!spec.copy && !slot.isObjType(ObjType::CELL)) {
+      slot = makeRef<Cell>(slot);
+    }
+    values.push_back(slot);
+  }
+
+  return values;
+}
+
+Value *Interpreter::globalCell(const SPToken &name, Value *&cache) {
+  // 全局单元不会被删除，缓存对之后重复定义的同名变量仍然有效
+  if (!cache) {
+    cache = globals->cell(name);
+  }
+  return cache;
+}
+
+void Interpreter::declare(const SPToken &name, const Value &value) {
+  if (environment == globals) {
+    globals->define(std::string(name->lexeme), value);
+  } else {
+    environment->define(value);
+  }
+}
 
-void Interpreter::executeBlock(std::shared_ptr<BlockStmt> blockStmt, SPEnvironment _environment) {
+Completion Interpreter::executeBlock(BlockStmt *blockStmt, SPEnvironment _environment) {
   SPEnvironment previous = environment;
   environment = std::move(_environment);
 
@@ -276,7 +404,10 @@ void Interpreter::executeBlock(std::shared_ptr<BlockStmt> blockStmt, SPEnvironme
 
   // try {
   for (auto &statement : blockStmt->statements) {
-    execute(statement);
+    if (execute(statement) == Completion::RETURN) {
+      finally();
+      return Completion::RETURN;
+    }
   }
   // } catch (...) { // catch any error
   //   finally();
@@ -284,74 +415,82 @@ void Interpreter::executeBlock(std::shared_ptr<BlockStmt> blockStmt, SPEnvironme
   // }
 
   finally();
+  return Completion::NORMAL;
 }
 
-void Interpreter::visitExprStmt(std::shared_ptr<ExprStmt> stmt) { evaluate(stmt->expression); }
+Completion Interpreter::visitExprStmt(ExprStmt *stmt) {
+  evaluate(stmt->expression);
+  return Completion::NORMAL;
+}
 
-void Interpreter::visitReturnStmt(std::shared_ptr<ReturnStmt> stmt) {
-  std::any value;
+Completion Interpreter::visitReturnStmt(ReturnStmt *stmt) {
+  Value value;
 
   if (stmt->value) {
     value = evaluate(stmt->value);
   }
 
-  throw ReturnValue(value);
+  returnValue = std::move(value);
+  return Completion::RETURN;
 }
 
-void Interpreter::visitPrintStmt(std::shared_ptr<PrintStmt> stmt) {
-  std::any value = evaluate(stmt->expression);
-
-  if (value.type() == typeid(SPCallable)) {
-    std::cout << std::any_cast<SPCallable>(value)->toString() << std::endl;
-    return;
-  }
-
-  if (value.type() == typeid(SPClass)) {
-    std::cout << std::any_cast<SPClass>(value)->toString() << std::endl;
-    return;
-  }
+Completion Interpreter::visitPrintStmt(PrintStmt *stmt) {
+  Value value = evaluate(stmt->expression);
 
-  if (value.type() == typeid(SPInstance)) {
-    std::cout << std::any_cast<SPInstance>(value)->toString() << std::endl;
-    return;
+  if (value.isObj()) {
+    std::cout << value.asObj()->toString() << std::endl;
+    return Completion::NORMAL;
   }
 
   std::cout << toString(value, "") << std::endl;
+  return Completion::NORMAL;
 }
 
-void Interpreter::visitFunStmt(std::shared_ptr<FunStmt> stmt) {
-  auto function = static_cast<SPCallable>(std::make_shared<Function>(stmt, environment, false));
-  environment->define(stmt->name->lexeme, function);
+Completion Interpreter::visitFunStmt(FunStmt *stmt) {
+  std::size_t slot = reserve();
+  auto function = makeRef<Function>(stmt, nullptr, false, unit->shared_from_this(), capture(stmt->captures, captures));
+  initialize(stmt->name, slot, function);
+  return Completion::NORMAL;
 }
 
-void Interpreter::visitClassStmt(std::shared_ptr<ClassStmt> stmt) {
+Completion Interpreter::visitClassStmt(ClassStmt *stmt) {
+  std::size_t slot = reserve();
+
   SPClass superclass = nullptr;
   if (stmt->superclass) {
-    std::any result = evaluate(stmt->superclass);
-    if (result.type() != typeid(SPClass)) {
+    Value result = evaluate(stmt->superclass);
+    if (!result.isClass()) {
       throw error(stmt->superclass->name, "Superclass must be a class.");
     }
-    superclass = std::any_cast<SPClass>(result);
+    superclass = result.asRef<Class>();
   }
 
-  SPEnvironment closure = std::make_shared<Environment>(environment);
+  // 类的环境链只包含this和super，外层变量通过捕获列表访问
+  SPEnvironment closure = Environment::create();
 
   if (stmt->superclass) {
-    closure->define("super", superclass);
-    closure = std::make_shared<Environment>(closure); // 额外包裹一层，对应resolver实现
+    closure->define(superclass);
+    closure = Environment::create(closure); // 额外包裹一层，对应resolver实现
   }
 
-  std::map<std::string, SPFunction> methods;
+  std::vector<Value> classCaptures = capture(stmt->captures, captures);
+
+  // 继承的方法直接复制到子类的方法表中，同名方法被子类覆盖
+  std::unordered_map<std::string, SPFunction> methods;
+  if (superclass) {
+    methods = superclass->methods;
+  }
   for (auto &method : stmt->instanceAttributes.methods) {
-    SPFunction function = std::make_shared<Function>(method, closure, method->name->lexeme == "init");
-    methods[method->name->lexeme] = function;
+    SPFunction function = makeRef<Function>(method, closure, method->name->lexeme == "init", unit->shared_from_this(),
+                                            capture(method->captures, &classCaptures));
+    methods[std::string(method->name->lexeme)] = function;
   }
 
-  auto klass =
-      std::make_shared<Class>(this, stmt->name, superclass, methods, stmt->instanceAttributes.variables, closure);
+  auto klass = makeRef<Class>(this, stmt->name, superclass, methods, stmt->instanceAttributes.variables, closure,
+                              unit->shared_from_this(), std::move(classCaptures));
 
   for (auto &variable : stmt->staticAttributes.variables) {
-    std::any value;
+    Value value;
     if (variable->initializer) {
       value = evaluate(variable->initializer);
     }
@@ -359,37 +498,59 @@ void Interpreter::visitClassStmt(std::shared_ptr<ClassStmt> stmt) {
   }
 
   for (auto &method : stmt->staticAttributes.methods) {
-    auto function = static_cast<SPCallable>(std::make_shared<Function>(method, environment, false));
+    auto function =
+        makeRef<Function>(method, nullptr, false, unit->shared_from_this(), capture(method->captures, captures));
     klass->set(method->name, function);
   }
 
-  environment->define(stmt->name->lexeme, klass);
+  initialize(stmt->name, slot, klass);
+  return Completion::NORMAL;
 }
 
-void Interpreter::visitVarStmt(std::shared_ptr<VarStmt> stmt) {
-  std::any value;
+Completion Interpreter::visitVarStmt(VarStmt *stmt) {
+  Value value;
   if (stmt->initializer) {
     value = evaluate(stmt->initializer);
   }
-  environment->define(stmt->name->lexeme, value);
+  declare(stmt->name, value);
+  return Completion::NORMAL;
 }
 
-void Interpreter::visitBlockStmt(std::shared_ptr<BlockStmt> stmt) {
-  executeBlock(stmt, std::make_shared<Environment>(environment));
+Completion Interpreter::visitBlockStmt(BlockStmt *stmt) {
+  if (stmt->hasEnvironment) {
+    return executeBlock(stmt, Environment::create(environment));
+  }
+
+  // 内联的块把变量追加在当前环境的槽位后面，离开时丢弃
+  std::size_t base = environment->slotCount();
+  Completion completion = Completion::NORMAL;
+  for (auto &statement : stmt->statements) {
+    completion = execute(statement);
+    if (completion == Completion::RETURN) {
+      break;
+    }
+  }
+  environment->truncate(base);
+  return completion;
 }
 
-void Interpreter::visitIfStmt(std::shared_ptr<IfStmt> stmt) {
+Completion Interpreter::visitIfStmt(IfStmt *stmt) {
   if (toBool(evaluate(stmt->condition), false)) {
-    execute(stmt->thenBranch);
+    return execute(stmt->thenBranch);
   } else if (stmt->elseBranch) {
-    execute(stmt->elseBranch);
+    return execute(stmt->elseBranch);
   }
+  return Completion::NORMAL;
 }
 
-void Interpreter::visitWhileStmt(std::shared_ptr<WhileStmt> stmt) {
+Completion Interpreter::visitWhileStmt(WhileStmt *stmt) {
   while (toBool(evaluate(stmt->condition), false)) {
-    execute(stmt->body);
+    if (execute(stmt->body) == Completion::RETURN) {
+      return Completion::RETURN;
+    }
+    Heap::getInstance().collectIfNeeded();
   }
+  return Completion::NORMAL;
 }
 
 InterpretError Interpreter::error(SPToken token, const std::string &message) {
@@ -397,10 +558,10 @@ InterpretError Interpreter::error(SPToken token, const std::string &message) {
   return {};
 }
 
-void Interpreter::interpret(std::vector<SPStmt> &statements, std::map<SPExpr, int> &_locals) {
-  reset();
-  locals = _locals;
-  for (auto &statement : statements) {
+void Interpreter::interpret(const SPCompilationUnit &_unit) {
+  unit = _unit.get();
+  captures = nullptr;
+  for (auto &statement : _unit->statements) {
     execute(statement);
   }
 }
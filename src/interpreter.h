@@ -1,69 +1,82 @@
 #ifndef CLOX_INTERPRETER_H
 #define CLOX_INTERPRETER_H
 
+#include "compilation_unit.h"
 #include "environment.h"
 #include "expr.h"
 #include "stmt.h"
 
 class InterpretError : public std::exception {};
 
-class ReturnValue : public std::exception {
-public:
-  std::any value;
-  explicit ReturnValue(std::any value) : value(std::move(value)) {}
-};
+// 语句的执行结果，return不再通过异常跳出函数体，而是逐层返回RETURN
+enum class Completion { NORMAL, RETURN };
 
-class Interpreter : public ExprVisitor<std::any>, StmtVisitor<void> {
+class Interpreter : public ExprVisitor<Value>, StmtVisitor<Completion> {
 private:
-  std::map<SPExpr, int> locals;
-  void reset();
-
-  static void checkNumberOperand(SPToken op, std::any &value);
-  static void checkNumberOperands(SPToken op, std::any &left, std::any &right);
-
-  std::any visitBinaryExpr(std::shared_ptr<BinaryExpr> expr) override;
-  std::any visitGroupingExpr(std::shared_ptr<GroupingExpr> expr) override;
-  std::any visitUnaryExpr(std::shared_ptr<UnaryExpr> expr) override;
-  std::any visitLiteralExpr(std::shared_ptr<LiteralExpr> expr) override;
-  std::any visitVariableExpr(std::shared_ptr<VariableExpr> expr) override;
-  std::any visitAssignExpr(std::shared_ptr<AssignExpr> expr) override;
-  std::any visitLogicalExpr(std::shared_ptr<LogicalExpr> expr) override;
-  std::any visitCallExpr(std::shared_ptr<CallExpr> expr) override;
-  std::any visitGetExpr(std::shared_ptr<GetExpr> expr) override;
-  std::any visitSetExpr(std::shared_ptr<SetExpr> expr) override;
-  std::any visitThisExpr(std::shared_ptr<ThisExpr> expr) override;
-  std::any visitSuperExpr(std::shared_ptr<SuperExpr> expr) override;
-
-  void execute(SPStmt stmt);
-
-  void visitExprStmt(std::shared_ptr<ExprStmt> stmt) override;
-  void visitReturnStmt(std::shared_ptr<ReturnStmt> stmt) override;
-  void visitPrintStmt(std::shared_ptr<PrintStmt> stmt) override;
-  void visitFunStmt(std::shared_ptr<FunStmt> stmt) override;
-  void visitClassStmt(std::shared_ptr<ClassStmt> stmt) override;
-  void visitVarStmt(std::shared_ptr<VarStmt> stmt) override;
-  void visitBlockStmt(std::shared_ptr<BlockStmt> stmt) override;
-  void visitIfStmt(std::shared_ptr<IfStmt> stmt) override;
-  void visitWhileStmt(std::shared_ptr<WhileStmt> stmt) override;
+  static void checkNumberOperand(const SPToken &op, const Value &value);
+  static void checkNumberOperands(const SPToken &op, const Value &left, const Value &right);
+  static void checkArity(const SPToken &paren, std::size_t arity, std::size_t count);
+  Value property(GetExpr *expr, const Value &object);
 
-  Interpreter();
+  Value visitBinaryExpr(BinaryExpr *expr) override;
+  Value visitGroupingExpr(GroupingExpr *expr) override;
+  Value visitUnaryExpr(UnaryExpr *expr) override;
+  Value visitLiteralExpr(LiteralExpr *expr) override;
+  Value visitVariableExpr(VariableExpr *expr) override;
+  Value visitAssignExpr(AssignExpr *expr) override;
+  Value visitLogicalExpr(LogicalExpr *expr) override;
+  Value visitCallExpr(CallExpr *expr) override;
+  Value visitGetExpr(GetExpr *expr) override;
+  Value visitSetExpr(SetExpr *expr) override;
+  Value visitThisExpr(ThisExpr *expr) override;
+  Value visitSuperExpr(SuperExpr *expr) override;
+
+  Completion execute(Stmt *stmt);
+  // 全局环境按名字定义，局部环境按声明顺序占用下一个槽位
+  void declare(const SPToken &name, const Value &value);
+  // 函数和类先占住槽位再创建，函数体和方法捕获自己时槽位已经存在
+  std::size_t reserve();
+  void initialize(const SPToken &name, std::size_t slot, const Value &value);
+  Value *globalCell(const SPToken &name, Value *&cache);
+
+  // 按resolver的解析结果读写局部变量，被捕获过的变量需要透过Cell
+  Value lookUp(const Resolution &resolution);
+  void assignLocal(const Resolution &resolution, const Value &value);
+  std::vector<Value> capture(const std::vector<Capture> &specs, const std::vector<Value> *enclosing);
 
-  template <typename T>
-  std::any handleCall(std::shared_ptr<CallExpr> expr, std::any callee, std::vector<std::any> &arguments);
+  Completion visitExprStmt(ExprStmt *stmt) override;
+  Completion visitReturnStmt(ReturnStmt *stmt) override;
+  Completion visitPrintStmt(PrintStmt *stmt) override;
+  Completion visitFunStmt(FunStmt *stmt) override;
+  Completion visitClassStmt(ClassStmt *stmt) override;
+  Completion visitVarStmt(VarStmt *stmt) override;
+  Completion visitBlockStmt(BlockStmt *stmt) override;
+  Completion visitIfStmt(IfStmt *stmt) override;
+  Completion visitWhileStmt(WhileStmt *stmt) override;
+
+  Interpreter();
 
 public:
   static Interpreter &getInstance();
   Interpreter(const Interpreter &) = delete;
   Interpreter &operator=(const Interpreter &) = delete;
 
-  SPEnvironment globals = std::make_shared<Environment>();
+  SPEnvironment globals = Environment::create();
   SPEnvironment environment = globals;
 
-  std::any evaluate(SPExpr expr);
-  void executeBlock(std::shared_ptr<BlockStmt> blockStmt, SPEnvironment _environment);
+  // 正在执行的语法树所属的编译单元，新建的函数和类会持有它
+  CompilationUnit *unit = nullptr;
+  // 正在执行的函数捕获的外层变量
+  std::vector<Value> *captures = nullptr;
+
+  // 最近一次执行的return语句的返回值，由Function::call取走
+  Value returnValue;
+
+  Value evaluate(Expr *expr);
+  Completion executeBlock(BlockStmt *blockStmt, SPEnvironment _environment);
 
   static InterpretError error(SPToken token, const std::string &message);
-  void interpret(std::vector<SPStmt> &statements, std::map<SPExpr, int> &_locals);
+  void interpret(const SPCompilationUnit &_unit);
 };
 
 #endif // CLOX_INTERPRETER_H
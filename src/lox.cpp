@@ -1,17 +1,39 @@
 #include "lox.h"
 #include "ast_printer.h"
+#include "compilation_unit.h"
+#include "compiler.h"
 #include "linenoise/linenoise.h"
 #include "util.h"
+#include "vm.h"
 #include <iostream>
 
 namespace lox {
 
+static Engine currentEngine = Engine::TREE;
+
+void setEngine(Engine engine) { currentEngine = engine; }
+
 void runCmd(int argc, char **argv) {
-  if (argc > 2) {
-    std::cout << "Usage: lox[ script]" << std::endl;
+  int index = 1;
+
+  if (index < argc && std::string(argv[index]).rfind("--engine=", 0) == 0) {
+    std::string engine = std::string(argv[index]).substr(9);
+    if (engine == "tree") {
+      setEngine(Engine::TREE);
+    } else if (engine == "vm") {
+      setEngine(Engine::VM);
+    } else {
+      std::cout << "Unknown engine '" << engine << "', expected tree or vm." << std::endl;
+      std::exit(64);
+    }
+    index++;
+  }
+
+  if (argc - index > 1) {
+    std::cout << "Usage: lox[ --engine=tree|vm][ script]" << std::endl;
     std::exit(64);
-  } else if (argc == 2) {
-    runFile(argv[1]);
+  } else if (argc - index == 1) {
+    runFile(argv[index]);
   } else {
     runRepl();
   }
@@ -55,25 +77,42 @@ void runRepl() {
 }
 
 void runFile(const std::string &path) {
-  std::string source = util::readFile(path);
-  runCode(source);
+  runCode(SourceBuffer::fromFile(path));
   if (hadError) {
     std::exit(65);
   }
 }
 
-void runCode(const std::string &code) {
+void runCode(std::string code) { runCode(SourceBuffer(std::move(code))); }
+
+void runCode(SourceBuffer source) {
+  // 本次运行的源码、token和语法树，没有被运行时对象引用时一次性释放
+  auto unit = std::make_shared<CompilationUnit>();
+  unit->source = std::move(source);
+
   Scanner &scanner = Scanner::getInstance();
-  std::vector<SPToken> tokens = scanner.scanTokens(code);
+  unit->tokens = scanner.scanTokens(unit->source.view());
 
   Parser &parser = Parser::getInstance();
-  std::vector<SPStmt> statements = parser.parse(tokens);
+  unit->statements = parser.parse(unit->tokens, unit->arena);
 
   Resolver &resolver = Resolver::getInstance();
-  std::map<SPExpr, int> locals = resolver.resolve(statements);
+  resolver.resolve(unit->statements);
+
+  if (currentEngine == Engine::VM) {
+    Compiler &compiler = Compiler::getInstance();
+    SPProto script = compiler.compile(*unit);
+    if (!script) {
+      return;
+    }
+
+    VM &vm = VM::getInstance();
+    vm.interpret(script);
+    return;
+  }
 
   Interpreter &interpreter = Interpreter::getInstance();
-  interpreter.interpret(statements, locals);
+  interpreter.interpret(unit);
 }
 
 void error(int line, const std::string &message) {
@@ -85,7 +124,7 @@ void error(SPToken token, const std::string &message) {
   if (token->type == TokenType::EOF_) {
     report(token->line, "Error at end", message);
   } else {
-    report(token->line, "Error at '" + token->lexeme + "'", message);
+    report(token->line, "Error at '" + std::string(token->lexeme) + "'", message);
   }
   hadError = true;
 }
@@ -99,7 +138,7 @@ void warn(SPToken token, const std::string &message) {
   if (token->type == TokenType::EOF_) {
     report(token->line, "Warn at end", message);
   } else {
-    report(token->line, "Warn at '" + token->lexeme + "'", message);
+    report(token->line, "Warn at '" + std::string(token->lexeme) + "'", message);
   }
   hadWarn = true;
 }
@@ -5,6 +5,7 @@
 #include "parser.h"
 #include "resolver.h"
 #include "scanner.h"
+#include "source_buffer.h"
 #include "token.h"
 #include <string>
 
@@ -13,16 +14,26 @@ namespace lox {
 static bool hadError;
 static bool hadWarn;
 
+// tree: 遍历语法树直接执行；vm: 编译成字节码后在虚拟机中执行
+enum class Engine {
+  TREE,
+  VM,
+};
+
 // 使用静态变量作为单例有很严重问题，如果类成员属性中包含静态属性，那么初始化顺序可能无法确定，会导致多次初始化
 // static Scanner scanner;
 // static Parser parser;
 // static Interpreter interpreter;
 // static Resolver resolver;
 
+void setEngine(Engine engine);
+
 void runCmd(int argc, char **argv);
 void runRepl();
+// path为"-"时从标准输入读取脚本
 void runFile(const std::string &path);
-void runCode(const std::string &code);
+void runCode(std::string code);
+void runCode(SourceBuffer source);
 
 void error(int line, const std::string &message);
 void error(SPToken token, const std::string &message);
@@ -3,8 +3,9 @@
 #include <iostream>
 
 void Parser::reset() {
-  tokens.clear();
+  tokens = nullptr;
   current = 0;
+  arena = nullptr;
 }
 
 SPToken Parser::advance() {
@@ -45,23 +46,23 @@ bool Parser::checkNext(TokenType type) {
   return peekNext()->type == type;
 }
 
-SPToken Parser::peek() { return tokens.at(current); }
+SPToken Parser::peek() { return &tokens->at(current); }
 
-SPToken Parser::peekPrev() { return tokens.at(current - 1); }
+SPToken Parser::peekPrev() { return &tokens->at(current - 1); }
 
-SPToken Parser::peekNext() { return tokens.at(current + 1); }
+SPToken Parser::peekNext() { return &tokens->at(current + 1); }
 
 bool Parser::isAtEnd() { return peek()->type == TokenType::EOF_; }
 
-SPExpr Parser::expression() { return assignment(); } // NOLINT(*-no-recursion)
+Expr *Parser::expression() { return assignment(); } // NOLINT(*-no-recursion)
 
-SPExpr Parser::assignment() { // NOLINT(*-no-recursion)
-  SPExpr expr = or_();
+Expr *Parser::assignment() { // NOLINT(*-no-recursion)
+  Expr *expr = or_();
 
   if (match({TokenType::EQUAL, TokenType::MINUS_EQUAL, TokenType::PLUS_EQUAL, TokenType::SLASH_EQUAL,
              TokenType::STAR_EQUAL})) {
     SPToken op = peekPrev();
-    SPExpr value = assignment();
+    Expr *value = assignment();
 
     // a = 1 => by default
     if (op->type == TokenType::EQUAL) {
@@ -69,31 +70,31 @@ SPExpr Parser::assignment() { // NOLINT(*-no-recursion)
     }
     // a -= 1 => a = a - 1
     if (op->type == TokenType::MINUS_EQUAL) {
-      SPToken newOp = std::make_shared<Token>(TokenType::MINUS, "-", nullptr, op->line);
-      value = std::make_shared<BinaryExpr>(expr, newOp, value);
+      SPToken newOp = arena->make<Token>(TokenType::MINUS, "-", nullptr, op->line);
+      value = arena->make<BinaryExpr>(expr, newOp, value);
     }
     // a += 1 => a = a + 1
     if (op->type == TokenType::PLUS_EQUAL) {
-      SPToken newOp = std::make_shared<Token>(TokenType::PLUS, "+", nullptr, op->line);
-      value = std::make_shared<BinaryExpr>(expr, newOp, value);
+      SPToken newOp = arena->make<Token>(TokenType::PLUS, "+", nullptr, op->line);
+      value = arena->make<BinaryExpr>(expr, newOp, value);
     }
     // a /= 1 => a = a / 1
     if (op->type == TokenType::SLASH_EQUAL) {
-      SPToken newOp = std::make_shared<Token>(TokenType::SLASH, "/", nullptr, op->line);
-      value = std::make_shared<BinaryExpr>(expr, newOp, value);
+      SPToken newOp = arena->make<Token>(TokenType::SLASH, "/", nullptr, op->line);
+      value = arena->make<BinaryExpr>(expr, newOp, value);
     }
     // a *= 1 => a = a * 1
     if (op->type == TokenType::STAR_EQUAL) {
-      SPToken newOp = std::make_shared<Token>(TokenType::STAR, "*", nullptr, op->line);
-      value = std::make_shared<BinaryExpr>(expr, newOp, value);
+      SPToken newOp = arena->make<Token>(TokenType::STAR, "*", nullptr, op->line);
+      value = arena->make<BinaryExpr>(expr, newOp, value);
     }
 
-    if (auto p = std::dynamic_pointer_cast<VariableExpr>(expr)) {
-      return std::make_shared<AssignExpr>(p->name, value, false);
+    if (auto p = dynamic_cast<VariableExpr *>(expr)) {
+      return arena->make<AssignExpr>(p->name, value, false);
     }
 
-    if (auto p = std::dynamic_pointer_cast<GetExpr>(expr)) {
-      return std::make_shared<SetExpr>(p->object, p->name, value, false);
+    if (auto p = dynamic_cast<GetExpr *>(expr)) {
+      return arena->make<SetExpr>(p->object, p->name, value, false);
     }
 
     throw error(op, "Invalid assignment target.");
@@ -102,129 +103,129 @@ SPExpr Parser::assignment() { // NOLINT(*-no-recursion)
   return expr;
 }
 
-SPExpr Parser::equality() { // NOLINT(*-no-recursion)
-  SPExpr expr = comparison();
+Expr *Parser::equality() { // NOLINT(*-no-recursion)
+  Expr *expr = comparison();
 
   while (match({TokenType::BANG_EQUAL, TokenType::EQUAL_EQUAL})) {
     SPToken op = peekPrev();
-    SPExpr right = comparison();
-    expr = std::make_shared<BinaryExpr>(expr, op, right);
+    Expr *right = comparison();
+    expr = arena->make<BinaryExpr>(expr, op, right);
   }
 
   return expr;
 }
 
-SPExpr Parser::comparison() { // NOLINT(*-no-recursion)
-  SPExpr expr = term();
+Expr *Parser::comparison() { // NOLINT(*-no-recursion)
+  Expr *expr = term();
 
   while (match({TokenType::GREATER, TokenType::GREATER_EQUAL, TokenType::LESS, TokenType::LESS_EQUAL})) {
     SPToken op = peekPrev();
-    SPExpr right = term();
-    expr = std::make_shared<BinaryExpr>(expr, op, right);
+    Expr *right = term();
+    expr = arena->make<BinaryExpr>(expr, op, right);
   }
 
   return expr;
 }
 
-SPExpr Parser::term() { // NOLINT(*-no-recursion)
-  SPExpr expr = factor();
+Expr *Parser::term() { // NOLINT(*-no-recursion)
+  Expr *expr = factor();
 
   while (match({TokenType::MINUS, TokenType::PLUS})) {
     SPToken op = peekPrev();
-    SPExpr right = factor();
-    expr = std::make_shared<BinaryExpr>(expr, op, right);
+    Expr *right = factor();
+    expr = arena->make<BinaryExpr>(expr, op, right);
   }
 
   return expr;
 }
 
-SPExpr Parser::factor() { // NOLINT(*-no-recursion)
-  SPExpr expr = exp();
+Expr *Parser::factor() { // NOLINT(*-no-recursion)
+  Expr *expr = exp();
 
   while (match({TokenType::SLASH, TokenType::STAR})) {
     SPToken op = peekPrev();
-    SPExpr right = exp();
-    expr = std::make_shared<BinaryExpr>(expr, op, right);
+    Expr *right = exp();
+    expr = arena->make<BinaryExpr>(expr, op, right);
   }
 
   return expr;
 }
 
-SPExpr Parser::exp() { // NOLINT(*-no-recursion)
-  SPExpr expr = unary();
+Expr *Parser::exp() { // NOLINT(*-no-recursion)
+  Expr *expr = unary();
 
   while (match({TokenType::STAR_STAR})) {
     SPToken op = peekPrev();
-    SPExpr right = unary();
-    expr = std::make_shared<BinaryExpr>(expr, op, right);
+    Expr *right = unary();
+    expr = arena->make<BinaryExpr>(expr, op, right);
   }
 
   return expr;
 }
 
-SPExpr unaryConvert(SPExpr expr, SPToken op, bool returnOriginal) {
+static Expr *unaryConvert(Arena *arena, Expr *expr, SPToken op, bool returnOriginal) {
   SPToken newOp = nullptr;
   if (op->type == TokenType::MINUS_MINUS) {
-    newOp = std::make_shared<Token>(TokenType::MINUS, "-", nullptr, op->line);
+    newOp = arena->make<Token>(TokenType::MINUS, "-", nullptr, op->line);
   } else {
-    newOp = std::make_shared<Token>(TokenType::PLUS, "+", nullptr, op->line);
+    newOp = arena->make<Token>(TokenType::PLUS, "+", nullptr, op->line);
   }
 
-  SPExpr one = std::make_shared<LiteralExpr>(1);
-  SPExpr value = std::make_shared<BinaryExpr>(expr, newOp, one);
+  Expr *one = arena->make<LiteralExpr>(1);
+  Expr *value = arena->make<BinaryExpr>(expr, newOp, one);
 
-  if (auto p = std::dynamic_pointer_cast<VariableExpr>(expr)) {
-    return std::make_shared<AssignExpr>(p->name, value, returnOriginal);
+  if (auto p = dynamic_cast<VariableExpr *>(expr)) {
+    return arena->make<AssignExpr>(p->name, value, returnOriginal);
   }
 
-  if (auto p = std::dynamic_pointer_cast<GetExpr>(expr)) {
-    return std::make_shared<SetExpr>(p->object, p->name, value, returnOriginal);
+  if (auto p = dynamic_cast<GetExpr *>(expr)) {
+    return arena->make<SetExpr>(p->object, p->name, value, returnOriginal);
   }
 
   throw Parser::error(op, "Expect variable " + static_cast<std::string>(returnOriginal ? "before" : "after") + " '" +
-                              op->lexeme + "'.");
+                              std::string(op->lexeme) + "'.");
 }
 
-SPExpr Parser::unary() { // NOLINT(*-no-recursion)
+Expr *Parser::unary() { // NOLINT(*-no-recursion)
   if (match({TokenType::BANG})) {
     SPToken op = peekPrev();
-    SPExpr right = unary();
-    return std::make_shared<UnaryExpr>(op, right);
+    Expr *right = unary();
+    return arena->make<UnaryExpr>(op, right);
   }
 
   // --a|++a => a=a-1|a=a+1
   if (match({TokenType::MINUS_MINUS, TokenType::PLUS_PLUS})) {
     SPToken op = peekPrev();
-    SPExpr expr = call();
-    return unaryConvert(expr, op, false);
+    Expr *expr = call();
+    return unaryConvert(arena, expr, op, false);
   }
 
   if (match({TokenType::PLUS, TokenType::MINUS})) {
     SPToken op = peekPrev();
-    SPExpr right = call();
-    return std::make_shared<UnaryExpr>(op, right);
+    Expr *right = call();
+    return arena->make<UnaryExpr>(op, right);
   }
 
-  SPExpr expr = call();
+  Expr *expr = call();
 
   // a--|a++ => a=a-1|a=a+1
   if (match({TokenType::MINUS_MINUS, TokenType::PLUS_PLUS})) {
     SPToken op = peekPrev();
-    return unaryConvert(expr, op, true);
+    return unaryConvert(arena, expr, op, true);
   }
 
   return expr;
 }
 
-SPExpr Parser::call() { // NOLINT(*-no-recursion)
-  SPExpr expr = primary();
+Expr *Parser::call() { // NOLINT(*-no-recursion)
+  Expr *expr = primary();
 
   while (true) {
     if (match({TokenType::LEFT_PAREN})) {
       expr = finishCall(expr);
     } else if (match({TokenType::DOT})) {
       SPToken name = consume(TokenType::IDENTIFIER, "Expect property name after '.'.");
-      expr = std::make_shared<GetExpr>(expr, name);
+      expr = arena->make<GetExpr>(expr, name);
     } else {
       break;
     }
@@ -233,8 +234,8 @@ SPExpr Parser::call() { // NOLINT(*-no-recursion)
   return expr;
 }
 
-SPExpr Parser::finishCall(SPExpr callee) { // NOLINT(*-no-recursion)
-  std::vector<SPExpr> arguments;
+Expr *Parser::finishCall(Expr *callee) { // NOLINT(*-no-recursion)
+  std::vector<Expr *> arguments;
 
   if (!check(TokenType::RIGHT_PAREN)) {
     do {
@@ -247,61 +248,61 @@ SPExpr Parser::finishCall(SPExpr callee) { // NOLINT(*-no-recursion)
 
   SPToken paren = consume(TokenType::RIGHT_PAREN, "Expect ')' after arguments.");
 
-  return std::make_shared<CallExpr>(callee, paren, arguments);
+  return arena->make<CallExpr>(callee, paren, arguments);
 }
 
-SPExpr Parser::primary() { // NOLINT(*-no-recursion)
+Expr *Parser::primary() { // NOLINT(*-no-recursion)
   if (match({TokenType::SUPER})) {
     SPToken keyword = peekPrev();
     consume(TokenType::DOT, "Expect '.' after 'super'.");
     SPToken method = consume(TokenType::IDENTIFIER, "Expect superclass method name.");
-    return std::make_shared<SuperExpr>(keyword, method);
+    return arena->make<SuperExpr>(keyword, method);
   }
   if (match({TokenType::THIS})) {
-    return std::make_shared<ThisExpr>(peekPrev());
+    return arena->make<ThisExpr>(peekPrev());
   }
   if (match({TokenType::FALSE})) {
-    return std::make_shared<LiteralExpr>(false);
+    return arena->make<LiteralExpr>(false);
   }
   if (match({TokenType::TRUE})) {
-    return std::make_shared<LiteralExpr>(true);
+    return arena->make<LiteralExpr>(true);
   }
   if (match({TokenType::NIL})) {
-    return std::make_shared<LiteralExpr>(nullptr);
+    return arena->make<LiteralExpr>(nullptr);
   }
   if (match({TokenType::STRING, TokenType::NUMBER})) {
-    return std::make_shared<LiteralExpr>(peekPrev()->literal);
+    return arena->make<LiteralExpr>(peekPrev()->literal);
   }
   if (match({TokenType::IDENTIFIER})) {
-    return std::make_shared<VariableExpr>(peekPrev());
+    return arena->make<VariableExpr>(peekPrev());
   }
   if (match({TokenType::LEFT_PAREN})) {
-    SPExpr expr = expression();
+    Expr *expr = expression();
     consume(TokenType::RIGHT_PAREN, "Expect ')' after expression.");
-    return std::make_shared<GroupingExpr>(expr);
+    return arena->make<GroupingExpr>(expr);
   }
   throw error(peek(), "Expect expression.");
 }
 
-SPExpr Parser::or_() { // NOLINT(*-no-recursion)
-  SPExpr expr = and_();
+Expr *Parser::or_() { // NOLINT(*-no-recursion)
+  Expr *expr = and_();
 
   while (match({TokenType::OR})) {
     SPToken op = peekPrev();
-    SPExpr right = and_();
-    expr = std::make_shared<LogicalExpr>(expr, op, right);
+    Expr *right = and_();
+    expr = arena->make<LogicalExpr>(expr, op, right);
   }
 
   return expr;
 }
 
-SPExpr Parser::and_() { // NOLINT(*-no-recursion)
-  SPExpr expr = equality();
+Expr *Parser::and_() { // NOLINT(*-no-recursion)
+  Expr *expr = equality();
 
   while (match({TokenType::AND})) {
     SPToken op = peekPrev();
-    SPExpr right = equality();
-    expr = std::make_shared<LogicalExpr>(expr, op, right);
+    Expr *right = equality();
+    expr = arena->make<LogicalExpr>(expr, op, right);
   }
 
   return expr;
@@ -342,7 +343,7 @@ void Parser::synchronize() {
   }
 }
 
-SPStmt Parser::statement() { // NOLINT(*-no-recursion)
+Stmt *Parser::statement() { // NOLINT(*-no-recursion)
   if (match({TokenType::FOR})) {
     return forStatement();
   }
@@ -370,17 +371,17 @@ SPStmt Parser::statement() { // NOLINT(*-no-recursion)
   return exprStatement();
 }
 
-SPStmt Parser::returnStatement() {
+Stmt *Parser::returnStatement() {
   SPToken keyword = peekPrev();
-  SPExpr value = nullptr;
+  Expr *value = nullptr;
   if (!check(TokenType::SEMICOLON)) {
     value = expression();
   }
   consume(TokenType::SEMICOLON, "Expect ';' after return value.");
-  return std::make_shared<ReturnStmt>(keyword, value);
+  return arena->make<ReturnStmt>(keyword, value);
 }
 
-SPStmt Parser::declaration() { // NOLINT(*-no-recursion)
+Stmt *Parser::declaration() { // NOLINT(*-no-recursion)
   try {
     if (match({TokenType::CLASS})) {
       return classDeclaration();
@@ -398,7 +399,7 @@ SPStmt Parser::declaration() { // NOLINT(*-no-recursion)
   }
 }
 
-std::shared_ptr<FunStmt> Parser::funDeclaration(const std::string &kind) { // NOLINT(*-no-recursion)
+FunStmt *Parser::funDeclaration(const std::string &kind) { // NOLINT(*-no-recursion)
   Modifier modifier = Modifier::NONE;
 
   if (match({TokenType::STATIC})) {
@@ -430,17 +431,17 @@ std::shared_ptr<FunStmt> Parser::funDeclaration(const std::string &kind) { // NO
 
   consume(TokenType::RIGHT_PAREN, "Expect ')' after parameters.");
   consume(TokenType::LEFT_BRACE, "Expect '{' before " + kind + " body.");
-  std::shared_ptr<BlockStmt> body = blockStatement();
-  return std::make_shared<FunStmt>(name, parameters, body, modifier);
+  BlockStmt *body = blockStatement();
+  return arena->make<FunStmt>(name, parameters, body, modifier);
 }
 
-SPStmt Parser::classDeclaration() { // NOLINT(*-no-recursion)
+Stmt *Parser::classDeclaration() { // NOLINT(*-no-recursion)
   SPToken name = consume(TokenType::IDENTIFIER, "Expect class name.");
 
-  std::shared_ptr<VariableExpr> superclass = nullptr;
+  VariableExpr *superclass = nullptr;
   if (match({TokenType::LESS})) {
     consume(TokenType::IDENTIFIER, "Expect superclass name.");
-    superclass = std::make_shared<VariableExpr>(peekPrev());
+    superclass = arena->make<VariableExpr>(peekPrev());
   }
 
   consume(TokenType::LEFT_BRACE, "Expect '{' before class body.");
@@ -454,7 +455,7 @@ SPStmt Parser::classDeclaration() { // NOLINT(*-no-recursion)
       while (!isAtEnd()) {
         if (peek()->type == TokenType::SEMICOLON) {
           current = start;
-          std::shared_ptr<VarStmt> variable = varDeclaration();
+          VarStmt *variable = varDeclaration();
           if (variable->modifier == Modifier::STATIC) {
             staticAttributes.variables.push_back(variable);
           } else {
@@ -465,7 +466,7 @@ SPStmt Parser::classDeclaration() { // NOLINT(*-no-recursion)
 
         if (peek()->type == TokenType::LEFT_BRACE) {
           current = start;
-          std::shared_ptr<FunStmt> method = funDeclaration("method");
+          FunStmt *method = funDeclaration("method");
           if (method->modifier == Modifier::STATIC) {
             staticAttributes.methods.push_back(method);
           } else {
@@ -483,10 +484,10 @@ SPStmt Parser::classDeclaration() { // NOLINT(*-no-recursion)
 
   consume(TokenType::RIGHT_BRACE, "Expect '}' after class body.");
 
-  return std::make_shared<ClassStmt>(name, superclass, instanceAttributes, staticAttributes);
+  return arena->make<ClassStmt>(name, superclass, instanceAttributes, staticAttributes);
 }
 
-std::shared_ptr<VarStmt> Parser::varDeclaration() {
+VarStmt *Parser::varDeclaration() {
   Modifier modifier = Modifier::NONE;
 
   if (match({TokenType::STATIC})) {
@@ -495,65 +496,65 @@ std::shared_ptr<VarStmt> Parser::varDeclaration() {
 
   SPToken name = consume(TokenType::IDENTIFIER, "Expect variable name.");
 
-  SPExpr initializer;
+  Expr *initializer = nullptr;
   if (match({TokenType::EQUAL})) {
     initializer = expression();
   }
 
   consume(TokenType::SEMICOLON, "Expect ';' after variable declaration.");
-  return std::make_shared<VarStmt>(name, initializer, modifier);
+  return arena->make<VarStmt>(name, initializer, modifier);
 }
 
-SPStmt Parser::exprStatement() {
-  SPExpr expr = expression();
+Stmt *Parser::exprStatement() {
+  Expr *expr = expression();
   consume(TokenType::SEMICOLON, "Expect ';' after expression.");
-  return std::make_shared<ExprStmt>(expr);
+  return arena->make<ExprStmt>(expr);
 }
 
-SPStmt Parser::printStatement() {
-  SPExpr expr = expression();
+Stmt *Parser::printStatement() {
+  Expr *expr = expression();
   consume(TokenType::SEMICOLON, "Expect ';' after expression.");
-  return std::make_shared<PrintStmt>(expr);
+  return arena->make<PrintStmt>(expr);
 }
 
-std::shared_ptr<BlockStmt> Parser::blockStatement() { // NOLINT(*-no-recursion)
-  std::vector<SPStmt> statements;
+BlockStmt *Parser::blockStatement() { // NOLINT(*-no-recursion)
+  std::vector<Stmt *> statements;
 
   while (!check(TokenType::RIGHT_BRACE) && !isAtEnd()) {
     statements.push_back(declaration());
   }
 
   consume(TokenType::RIGHT_BRACE, "Expect '}' after block.");
-  return std::make_shared<BlockStmt>(statements);
+  return arena->make<BlockStmt>(statements);
 }
 
-SPStmt Parser::ifStatement() { // NOLINT(*-no-recursion)
+Stmt *Parser::ifStatement() { // NOLINT(*-no-recursion)
   consume(TokenType::LEFT_PAREN, "Expect '(' after 'if'.");
-  SPExpr condition = expression();
+  Expr *condition = expression();
   consume(TokenType::RIGHT_PAREN, "Expect ')' after if condition.");
 
-  SPStmt thenBranch = statement();
-  SPStmt elseBranch;
+  Stmt *thenBranch = statement();
+  Stmt *elseBranch = nullptr;
   if (match({TokenType::ELSE})) {
     elseBranch = statement();
   }
 
-  return std::make_shared<IfStmt>(condition, thenBranch, elseBranch);
+  return arena->make<IfStmt>(condition, thenBranch, elseBranch);
 }
 
-SPStmt Parser::whileStatement() { // NOLINT(*-no-recursion)
+Stmt *Parser::whileStatement() { // NOLINT(*-no-recursion)
   consume(TokenType::LEFT_PAREN, "Expect '(' after 'while'.");
-  SPExpr condition = expression();
+  Expr *condition = expression();
   consume(TokenType::RIGHT_PAREN, "Expect ')' after while condition.");
-  SPStmt body = statement();
+  Stmt *body = statement();
 
-  return std::make_shared<WhileStmt>(condition, body);
+  return arena->make<WhileStmt>(condition, body);
 }
 
-SPStmt Parser::forStatement() { // NOLINT(*-no-recursion)
+Stmt *Parser::forStatement() { // NOLINT(*-no-recursion)
   consume(TokenType::LEFT_PAREN, "Expect '(' after 'for'.");
 
-  SPStmt initializer = nullptr;
+  Stmt *initializer = nullptr;
   if (match({TokenType::SEMICOLON})) {
     // for (; ...; ...)
   } else if (match({TokenType::VAR})) {
@@ -562,32 +563,32 @@ SPStmt Parser::forStatement() { // NOLINT(*-no-recursion)
     initializer = exprStatement(); // for (expression; ...; ...)
   }
 
-  SPExpr condition;
+  Expr *condition = nullptr;
   if (!check(TokenType::SEMICOLON)) {
     condition = expression(); // for (...; condition; ...)
   }
   consume(TokenType::SEMICOLON, "Expect ';' after loop condition.");
 
-  SPExpr increment;
+  Expr *increment = nullptr;
   if (!check(TokenType::RIGHT_PAREN)) {
     increment = expression(); // for (...; ...; increment)
   }
   consume(TokenType::RIGHT_PAREN, "Expect ')' after for clauses.");
 
-  SPStmt body = statement();
+  Stmt *body = statement();
 
   if (increment) {
-    body = std::make_shared<BlockStmt>(std::vector<SPStmt>{body, std::make_shared<ExprStmt>(increment)});
+    body = arena->make<BlockStmt>(std::vector<Stmt *>{body, arena->make<ExprStmt>(increment)});
   }
 
   if (!condition) {
-    condition = std::make_shared<LiteralExpr>(true);
+    condition = arena->make<LiteralExpr>(true);
   }
 
-  body = std::make_shared<WhileStmt>(condition, body);
+  body = arena->make<WhileStmt>(condition, body);
 
   if (initializer) {
-    body = std::make_shared<BlockStmt>(std::vector<SPStmt>{initializer, body});
+    body = arena->make<BlockStmt>(std::vector<Stmt *>{initializer, body});
   }
 
   return body;
@@ -598,16 +599,17 @@ ParseError Parser::error(SPToken token, const std::string &message) {
   return {};
 }
 
-std::vector<SPStmt> Parser::parse(std::vector<SPToken> &_tokens) {
+std::vector<Stmt *> Parser::parse(const std::vector<Token> &_tokens, Arena &_arena) {
   reset();
 
-  tokens = _tokens;
+  tokens = &_tokens;
+  arena = &_arena;
 
-  std::vector<SPStmt> statements;
+  std::vector<Stmt *> statements;
 
   while (!isAtEnd()) {
     // 存在空指针，可能有问题
-    SPStmt statement = declaration();
+    Stmt *statement = declaration();
     if (statement) {
       statements.push_back(statement);
     }
@@ -1,6 +1,7 @@
 #ifndef CLOX_PARSER_H
 #define CLOX_PARSER_H
 
+#include "arena.h"
 #include "expr.h"
 #include "stmt.h"
 #include <vector>
@@ -9,9 +10,13 @@ class ParseError : public std::exception {};
 
 class Parser {
 private:
-  std::vector<SPToken> tokens;
+  // 编译单元中的token，解析器合成的token分配在Arena中
+  const std::vector<Token> *tokens = nullptr;
   int current = 0;
 
+  // 语法树节点都分配在编译单元的Arena中
+  Arena *arena = nullptr;
+
   void reset();
 
   bool isAtEnd();
@@ -25,36 +30,36 @@ private:
   SPToken peekNext();
   SPToken consume(TokenType type, const std::string &message);
 
-  SPExpr expression();
-  SPExpr assignment();
-  SPExpr equality();
-  SPExpr comparison();
-  SPExpr term();
-  SPExpr factor();
-  SPExpr exp();
-  SPExpr unary();
-  SPExpr call();
-  SPExpr finishCall(SPExpr expr);
-  SPExpr primary();
-  SPExpr or_();
-  SPExpr and_();
+  Expr *expression();
+  Expr *assignment();
+  Expr *equality();
+  Expr *comparison();
+  Expr *term();
+  Expr *factor();
+  Expr *exp();
+  Expr *unary();
+  Expr *call();
+  Expr *finishCall(Expr *expr);
+  Expr *primary();
+  Expr *or_();
+  Expr *and_();
 
   void synchronize();
 
-  SPStmt statement();
+  Stmt *statement();
 
-  SPStmt declaration();
-  std::shared_ptr<FunStmt> funDeclaration(const std::string &kind);
-  SPStmt classDeclaration();
-  std::shared_ptr<VarStmt> varDeclaration();
+  Stmt *declaration();
+  FunStmt *funDeclaration(const std::string &kind);
+  Stmt *classDeclaration();
+  VarStmt *varDeclaration();
 
-  SPStmt exprStatement();
-  SPStmt returnStatement();
-  SPStmt printStatement();
-  std::shared_ptr<BlockStmt> blockStatement();
-  SPStmt ifStatement();
-  SPStmt whileStatement();
-  SPStmt forStatement();
+  Stmt *exprStatement();
+  Stmt *returnStatement();
+  Stmt *printStatement();
+  BlockStmt *blockStatement();
+  Stmt *ifStatement();
+  Stmt *whileStatement();
+  Stmt *forStatement();
 
   Parser() = default;
 
@@ -64,7 +69,7 @@ public:
   Parser &operator=(const Parser &) = delete;
 
   static ParseError error(SPToken token, const std::string &message);
-  std::vector<SPStmt> parse(std::vector<SPToken> &_tokens);
+  std::vector<Stmt *> parse(const std::vector<Token> &_tokens, Arena &_arena);
 };
 
 #endif // CLOX_PARSER_H
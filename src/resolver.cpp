@@ -2,9 +2,7 @@
 #include "lox.h"
 #include <iostream>
 
-void Resolver::reset() { locals.clear(); }
-
-void Resolver::visitVariableExpr(std::shared_ptr<VariableExpr> expr) {
+void Resolver::visitVariableExpr(VariableExpr *expr) {
   // 不能在未定义情况下使用，比如变量定义初始化表达式包含自身
   if (!scopes.empty()) {
     ScopeData *found = findInScope(scopes.back(), expr->name);
@@ -13,31 +11,31 @@ void Resolver::visitVariableExpr(std::shared_ptr<VariableExpr> expr) {
     }
   }
 
-  resolveLocal(expr, expr->name);
+  resolveLocal(expr->resolution, expr->name);
 }
 
-void Resolver::visitAssignExpr(std::shared_ptr<AssignExpr> expr) {
+void Resolver::visitAssignExpr(AssignExpr *expr) {
   resolve(expr->value);
-  resolveLocal(expr, expr->name);
+  resolveLocal(expr->resolution, expr->name);
 }
 
-void Resolver::visitBinaryExpr(std::shared_ptr<BinaryExpr> expr) {
+void Resolver::visitBinaryExpr(BinaryExpr *expr) {
   resolve(expr->left);
   resolve(expr->right);
 }
 
-void Resolver::visitGroupingExpr(std::shared_ptr<GroupingExpr> expr) { resolve(expr->expression); }
+void Resolver::visitGroupingExpr(GroupingExpr *expr) { resolve(expr->expression); }
 
-void Resolver::visitUnaryExpr(std::shared_ptr<UnaryExpr> expr) { resolve(expr->right); }
+void Resolver::visitUnaryExpr(UnaryExpr *expr) { resolve(expr->right); }
 
-void Resolver::visitLiteralExpr(std::shared_ptr<LiteralExpr> expr) {}
+void Resolver::visitLiteralExpr(LiteralExpr *expr) {}
 
-void Resolver::visitLogicalExpr(std::shared_ptr<LogicalExpr> expr) {
+void Resolver::visitLogicalExpr(LogicalExpr *expr) {
   resolve(expr->left);
   resolve(expr->right);
 }
 
-void Resolver::visitCallExpr(std::shared_ptr<CallExpr> expr) {
+void Resolver::visitCallExpr(CallExpr *expr) {
   resolve(expr->callee);
 
   for (auto &argument : expr->arguments) {
@@ -45,14 +43,14 @@ void Resolver::visitCallExpr(std::shared_ptr<CallExpr> expr) {
   }
 }
 
-void Resolver::visitGetExpr(std::shared_ptr<GetExpr> expr) { resolve(expr->object); }
+void Resolver::visitGetExpr(GetExpr *expr) { resolve(expr->object); }
 
-void Resolver::visitSetExpr(std::shared_ptr<SetExpr> expr) {
+void Resolver::visitSetExpr(SetExpr *expr) {
   resolve(expr->object);
   resolve(expr->value);
 }
 
-void Resolver::visitThisExpr(std::shared_ptr<ThisExpr> expr) {
+void Resolver::visitThisExpr(ThisExpr *expr) {
   if (currentClass == ClassType::NONE) {
     throw error(expr->keyword, "Can't use 'this' outside of a class.");
   }
@@ -61,20 +59,24 @@ void Resolver::visitThisExpr(std::shared_ptr<ThisExpr> expr) {
     throw error(expr->keyword, "Static attribute can't use 'this'.");
   }
 
-  resolveLocal(expr, expr->keyword);
+  resolveLocal(expr->resolution, expr->keyword);
 }
 
-void Resolver::visitSuperExpr(std::shared_ptr<SuperExpr> expr) {
+void Resolver::visitSuperExpr(SuperExpr *expr) {
   if (currentClass == ClassType::NONE) {
     throw error(expr->keyword, "Can't use 'super' outside of a class.");
   }
   if (currentClass != ClassType::SUBCLASS) {
     throw error(expr->keyword, "Can't use 'super' in a class with no superclass.");
   }
-  resolveLocal(expr, expr->keyword);
+  resolveLocal(expr->resolution, expr->keyword);
+
+  // 方法绑定的this和super来自同一个类，在嵌套函数中可能分别被捕获
+  Token self(TokenType::THIS, "this", nullptr, expr->keyword->line);
+  resolveLocal(expr->thisResolution, &self);
 }
 
-void Resolver::visitVarStmt(std::shared_ptr<VarStmt> stmt) {
+void Resolver::visitVarStmt(VarStmt *stmt) {
   declare(stmt->name);
   if (stmt->initializer) {
     resolve(stmt->initializer);
@@ -82,15 +84,18 @@ void Resolver::visitVarStmt(std::shared_ptr<VarStmt> stmt) {
   define(stmt->name);
 }
 
-void Resolver::visitBlockStmt(std::shared_ptr<BlockStmt> stmt) {
-  beginScope();
+void Resolver::visitBlockStmt(BlockStmt *stmt) {
+  // 块中没有函数和类声明时，不会有闭包捕获它的变量；顶层的块仍然需要环境，全局环境只按名字保存变量
+  stmt->hasEnvironment = scopes.size() <= 1 || createsClosure(stmt);
+
+  beginScope(!stmt->hasEnvironment);
   for (auto &statement : stmt->statements) {
     resolve(statement);
   }
   endScope();
 }
 
-void Resolver::visitFunStmt(std::shared_ptr<FunStmt> stmt) {
+void Resolver::visitFunStmt(FunStmt *stmt) {
   declare(stmt->name);
   define(stmt->name);
 
@@ -101,7 +106,7 @@ void Resolver::visitFunStmt(std::shared_ptr<FunStmt> stmt) {
   resolveFunction(stmt, FunctionType::FUNCTION);
 }
 
-void Resolver::visitClassStmt(std::shared_ptr<ClassStmt> stmt) {
+void Resolver::visitClassStmt(ClassStmt *stmt) {
   ClassType enclosingClass = currentClass;
   currentClass = ClassType::CLASS;
 
@@ -116,16 +121,20 @@ void Resolver::visitClassStmt(std::shared_ptr<ClassStmt> stmt) {
     resolve(stmt->superclass);
   }
 
+  frames.push_back(ClosureFrame{scopes.size(), &stmt->captures});
+
   // 允许在上下文中注入super，像this一样的操作
   if (stmt->superclass) {
     beginScope();
     Scope &scope = scopes.back();
-    scope.emplace("super", ScopeData{stmt->name, true, true});
+    scope.emplace("super", ScopeData{stmt->name, true, true, 0, false, {}});
+    scope.nextSlot = 1;
   }
 
   beginScope();
   Scope &scope = scopes.back();
-  scope.emplace("this", ScopeData{stmt->name, true, true});
+  scope.emplace("this", ScopeData{stmt->name, true, true, 0, false, {}});
+  scope.nextSlot = 1;
 
   for (auto &variable : stmt->instanceAttributes.variables) {
     if (variable->initializer) {
@@ -138,7 +147,7 @@ void Resolver::visitClassStmt(std::shared_ptr<ClassStmt> stmt) {
     if (method->name->lexeme == "init") {
       type = FunctionType::INITIALIZER;
     }
-    resolveFunction(method, type);
+    resolveFunction(method, type, true);
   }
 
   endScope();
@@ -147,6 +156,8 @@ void Resolver::visitClassStmt(std::shared_ptr<ClassStmt> stmt) {
     endScope();
   }
 
+  frames.pop_back();
+
   // 静态方法不能调用this和super
   StaticType enclosingStatic = currentStatic;
   currentStatic = StaticType::CLASS;
@@ -172,9 +183,9 @@ void Resolver::visitClassStmt(std::shared_ptr<ClassStmt> stmt) {
   currentClass = enclosingClass;
 }
 
-void Resolver::visitExprStmt(std::shared_ptr<ExprStmt> stmt) { resolve(stmt->expression); }
+void Resolver::visitExprStmt(ExprStmt *stmt) { resolve(stmt->expression); }
 
-void Resolver::visitIfStmt(std::shared_ptr<IfStmt> stmt) {
+void Resolver::visitIfStmt(IfStmt *stmt) {
   resolve(stmt->condition);
   resolve(stmt->thenBranch);
   if (stmt->elseBranch) {
@@ -182,9 +193,9 @@ void Resolver::visitIfStmt(std::shared_ptr<IfStmt> stmt) {
   }
 }
 
-void Resolver::visitPrintStmt(std::shared_ptr<PrintStmt> stmt) { resolve(stmt->expression); }
+void Resolver::visitPrintStmt(PrintStmt *stmt) { resolve(stmt->expression); }
 
-void Resolver::visitReturnStmt(std::shared_ptr<ReturnStmt> stmt) {
+void Resolver::visitReturnStmt(ReturnStmt *stmt) {
   if (currentFunction == FunctionType::NONE) {
     throw error(stmt->keyword, "Can't return from top-level code.");
   }
@@ -198,47 +209,154 @@ void Resolver::visitReturnStmt(std::shared_ptr<ReturnStmt> stmt) {
   }
 }
 
-void Resolver::visitWhileStmt(std::shared_ptr<WhileStmt> stmt) {
+void Resolver::visitWhileStmt(WhileStmt *stmt) {
   resolve(stmt->condition);
   resolve(stmt->body);
 }
 
-void Resolver::beginScope() { scopes.emplace_back(); }
+void Resolver::beginScope(bool inlined) {
+  int base = inlined ? owner().nextSlot : 0;
+  Scope &scope = scopes.emplace_back();
+  scope.inlined = inlined;
+  scope.nextSlot = base;
+}
 
 void Resolver::endScope() {
   Scope &scope = scopes.back();
 
+  // 内联的块结束后，它占用的槽位可以被外层后续的变量复用
+  if (scope.inlined) {
+    owner().nextSlot = scope.nextSlot;
+  }
+
   for (auto &[key, value] : scope) {
     if (!value.used) {
       warn(value.name, "Variable unused.");
     }
+    if (value.captured) {
+      for (Resolution *use : value.uses) {
+        use->boxed = true;
+      }
+    }
   }
 
   scopes.pop_back();
 }
 
-void Resolver::resolve(SPStmt stmt) { visitStmt(std::move(stmt)); }
+void Resolver::resolve(Stmt *stmt) { visitStmt(stmt); }
 
-void Resolver::resolve(SPExpr expr) { visitExpr(std::move(expr)); }
+void Resolver::resolve(Expr *expr) { visitExpr(expr); }
 
-void Resolver::resolveLocal(SPExpr expr, SPToken name) {
+void Resolver::resolveLocal(Resolution &resolution, const SPToken &name) {
   auto size = static_cast<int>(scopes.size()); // 原本的 unsigned long 不转成 int 会导致从零减一后变为一个很大的正值
   for (int i = size - 1; i >= 0; i--) {
     Scope &scope = scopes.at(i);
     ScopeData *found = findInScope(scope, name);
     if (found) {
-      locals[expr] = size - 1 - i;
       found->used = true;
+
+      if (i == 0) { // 顶层作用域对应全局环境
+        resolution.depth = Resolution::GLOBAL;
+        resolution.slot = found->slot;
+      } else if (frames.empty() || i >= frames.back().base) {
+        resolution.depth = distance(i, size - 1);
+        resolution.slot = found->slot;
+        found->uses.push_back(&resolution);
+      } else { // 当前闭包之外的变量
+        resolution.depth = Resolution::UPVALUE;
+        resolution.slot = resolveUpvalue(frames.size() - 1, i, found, name);
+      }
       return;
     }
   }
 }
 
-void Resolver::resolveFunction(std::shared_ptr<FunStmt> function, FunctionType type) {
+// NOLINTNEXTLINE(*-no-recursion)
+int Resolver::resolveUpvalue(std::size_t frame, int scope, ScopeData *data, const SPToken &name) {
+  ClosureFrame &closure = frames.at(frame);
+
+  Capture capture{};
+  if (frame == 0 || scope >= frames.at(frame - 1).base) {
+    // 变量就在创建闭包的环境链上
+    bool copy = name->type == TokenType::THIS || name->type == TokenType::SUPER;
+    capture = Capture{true, copy, distance(scope, static_cast<int>(closure.base) - 1), data->slot};
+    if (!copy) {
+      data->captured = true;
+    }
+  } else {
+    capture = Capture{false, false, 0, resolveUpvalue(frame - 1, scope, data, name)};
+  }
+
+  std::vector<Capture> &captures = *closure.captures;
+  for (int i = 0; i < captures.size(); i++) {
+    Capture &existing = captures.at(i);
+    if (existing.isLocal == capture.isLocal && existing.depth == capture.depth && existing.index == capture.index) {
+      return i;
+    }
+  }
+  captures.push_back(capture);
+  return static_cast<int>(captures.size()) - 1;
+}
+
+int Resolver::distance(int from, int to) {
+  // 内联的块和外层共用一个环境
+  int depth = 0;
+  for (int i = from + 1; i <= to; i++) {
+    if (!scopes.at(i).inlined) {
+      depth++;
+    }
+  }
+  return depth;
+}
+
+Scope &Resolver::owner() {
+  for (auto it = scopes.rbegin(); it != scopes.rend(); it++) {
+    if (!it->inlined) {
+      return *it;
+    }
+  }
+  return scopes.front();
+}
+
+bool Resolver::createsClosure(Stmt *stmt) { // NOLINT(*-no-recursion)
+  switch (stmt->kind) {
+    case StmtKind::FUN:
+    case StmtKind::CLASS: {
+      return true;
+    }
+    case StmtKind::BLOCK: {
+      for (auto &statement : static_cast<BlockStmt *>(stmt)->statements) {
+        if (createsClosure(statement)) {
+          return true;
+        }
+      }
+      return false;
+    }
+    case StmtKind::IF: {
+      auto ifStmt = static_cast<IfStmt *>(stmt);
+      return createsClosure(ifStmt->thenBranch) || (ifStmt->elseBranch && createsClosure(ifStmt->elseBranch));
+    }
+    case StmtKind::WHILE: {
+      return createsClosure(static_cast<WhileStmt *>(stmt)->body);
+    }
+    default: {
+      return false;
+    }
+  }
+}
+
+void Resolver::resolveFunction(FunStmt *function, FunctionType type, bool method) {
   FunctionType enclosingFunction = currentFunction;
   currentFunction = type;
 
+  // 实例方法执行时的环境链包含类的this和super
+  frames.push_back(ClosureFrame{method ? frames.back().base : scopes.size(), &function->captures});
+
   beginScope();
+  if (method) {
+    // 接收者随每次调用放在方法自己环境的0号槽位，类环境中的this只留给字段初始化表达式
+    scopes.back().emplace("this", ScopeData{function->name, true, true, owner().nextSlot++, false, {}});
+  }
   for (auto &param : function->params) {
     declare(param);
     define(param);
@@ -248,6 +366,8 @@ void Resolver::resolveFunction(std::shared_ptr<FunStmt> function, FunctionType t
   }
   endScope();
 
+  frames.pop_back();
+
   currentFunction = enclosingFunction;
 }
 
@@ -273,6 +393,9 @@ void Resolver::declare(SPToken name) {
                                     name,
                                     false,
                                     false,
+                                    owner().nextSlot++,
+                                    false,
+                                    {},
                                 }); // 声明
   } else {
     throw error(name, "Already declared a variable with this name in this scope.");
@@ -299,14 +422,12 @@ ResolverError Resolver::error(SPToken token, const std::string &message) {
 
 void Resolver::warn(SPToken token, const std::string &message) { lox::warn(std::move(token), message); }
 
-std::map<SPExpr, int> Resolver::resolve(std::vector<SPStmt> &statements) {
-  reset();
+void Resolver::resolve(std::vector<Stmt *> &statements) {
   beginScope();
   for (auto &statement : statements) {
     resolve(statement);
   }
   endScope();
-  return locals;
 }
 
 Resolver &Resolver::getInstance() {
@@ -16,9 +16,25 @@ struct ScopeData {
   SPToken name;
   bool defined;
   bool used;
+  int slot;
+  // 被内层闭包装箱捕获，作用域结束时标记所有使用处
+  bool captured = false;
+  std::vector<Resolution *> uses;
 };
 
-class Scope : public std::map<std::string, ScopeData> {};
+// 函数和类会创建闭包，base是闭包自己的环境链在scopes中开始的位置，更外层的变量通过captures捕获
+struct ClosureFrame {
+  std::size_t base;
+  std::vector<Capture> *captures;
+};
+
+class Scope : public std::map<std::string, ScopeData, std::less<>> {
+public:
+  // 内联的块没有自己的环境，变量借用外层环境的槽位
+  bool inlined = false;
+  // 有环境的作用域中下一个空闲槽位；内联的块记录进入时的位置，结束后外层环境回退到这里
+  int nextSlot = 0;
+};
 
 class ResolverError : public std::exception {};
 
@@ -28,42 +44,44 @@ private:
   ClassType currentClass = ClassType::NONE;
   StaticType currentStatic = StaticType::NONE;
 
-  std::map<SPExpr, int> locals;
-  void reset();
-
-  void visitBinaryExpr(std::shared_ptr<BinaryExpr> expr) override;
-  void visitGroupingExpr(std::shared_ptr<GroupingExpr> expr) override;
-  void visitUnaryExpr(std::shared_ptr<UnaryExpr> expr) override;
-  void visitLiteralExpr(std::shared_ptr<LiteralExpr> expr) override;
-  void visitVariableExpr(std::shared_ptr<VariableExpr> expr) override;
-  void visitAssignExpr(std::shared_ptr<AssignExpr> expr) override;
-  void visitLogicalExpr(std::shared_ptr<LogicalExpr> expr) override;
-  void visitCallExpr(std::shared_ptr<CallExpr> expr) override;
-  void visitGetExpr(std::shared_ptr<GetExpr> expr) override;
-  void visitSetExpr(std::shared_ptr<SetExpr> expr) override;
-  void visitThisExpr(std::shared_ptr<ThisExpr> expr) override;
-  void visitSuperExpr(std::shared_ptr<SuperExpr> expr) override;
-
-  void visitExprStmt(std::shared_ptr<ExprStmt> stmt) override;
-  void visitReturnStmt(std::shared_ptr<ReturnStmt> stmt) override;
-  void visitPrintStmt(std::shared_ptr<PrintStmt> stmt) override;
-  void visitFunStmt(std::shared_ptr<FunStmt> stmt) override;
-  void visitClassStmt(std::shared_ptr<ClassStmt> stmt) override;
-  void visitVarStmt(std::shared_ptr<VarStmt> stmt) override;
-  void visitBlockStmt(std::shared_ptr<BlockStmt> stmt) override;
-  void visitIfStmt(std::shared_ptr<IfStmt> stmt) override;
-  void visitWhileStmt(std::shared_ptr<WhileStmt> stmt) override;
-
-  void beginScope();
+  void visitBinaryExpr(BinaryExpr *expr) override;
+  void visitGroupingExpr(GroupingExpr *expr) override;
+  void visitUnaryExpr(UnaryExpr *expr) override;
+  void visitLiteralExpr(LiteralExpr *expr) override;
+  void visitVariableExpr(VariableExpr *expr) override;
+  void visitAssignExpr(AssignExpr *expr) override;
+  void visitLogicalExpr(LogicalExpr *expr) override;
+  void visitCallExpr(CallExpr *expr) override;
+  void visitGetExpr(GetExpr *expr) override;
+  void visitSetExpr(SetExpr *expr) override;
+  void visitThisExpr(ThisExpr *expr) override;
+  void visitSuperExpr(SuperExpr *expr) override;
+
+  void visitExprStmt(ExprStmt *stmt) override;
+  void visitReturnStmt(ReturnStmt *stmt) override;
+  void visitPrintStmt(PrintStmt *stmt) override;
+  void visitFunStmt(FunStmt *stmt) override;
+  void visitClassStmt(ClassStmt *stmt) override;
+  void visitVarStmt(VarStmt *stmt) override;
+  void visitBlockStmt(BlockStmt *stmt) override;
+  void visitIfStmt(IfStmt *stmt) override;
+  void visitWhileStmt(WhileStmt *stmt) override;
+
+  void beginScope(bool inlined = false);
   void endScope();
+  Scope &owner();
+  static bool createsClosure(Stmt *stmt);
 
-  void resolve(SPStmt stmt);
-  void resolve(SPExpr expr);
+  void resolve(Stmt *stmt);
+  void resolve(Expr *expr);
 
-  void resolveLocal(SPExpr expr, SPToken name);
-  void resolveFunction(std::shared_ptr<FunStmt> function, FunctionType type);
+  void resolveLocal(Resolution &resolution, const SPToken &name);
+  int resolveUpvalue(std::size_t frame, int scope, ScopeData *data, const SPToken &name);
+  void resolveFunction(FunStmt *function, FunctionType type, bool method = false);
+  int distance(int from, int to);
 
   std::deque<Scope> scopes;
+  std::vector<ClosureFrame> frames;
   static ScopeData *findInScope(Scope &scope, SPToken name);
 
   void declare(SPToken name);
@@ -79,7 +97,7 @@ public:
   static ResolverError error(SPToken token, const std::string &message);
   static void warn(SPToken token, const std::string &message);
 
-  std::map<SPExpr, int> resolve(std::vector<SPStmt> &statements);
+  void resolve(std::vector<Stmt *> &statements);
 };
 
 #endif // CLOX_RESOLVER_H
@@ -1,7 +1,17 @@
 #include "scanner.h"
 #include "lox.h"
+#include "simd.h"
+#include <array>
+#include <charconv>
 
-std::map<std::string, TokenType> Scanner::keywords = {
+namespace {
+
+struct Keyword {
+  std::string_view name;
+  TokenType type;
+};
+
+constexpr Keyword KEYWORDS[] = {
     {"getter", TokenType::GETTER}, {"setter", TokenType::SETTER}, {"static", TokenType::STATIC},
     {"and", TokenType::AND},       {"class", TokenType::CLASS},   {"else", TokenType::ELSE},
     {"false", TokenType::FALSE},   {"for", TokenType::FOR},       {"fun", TokenType::FUN},
@@ -11,16 +21,54 @@ std::map<std::string, TokenType> Scanner::keywords = {
     {"while", TokenType::WHILE},
 };
 
-std::optional<TokenType> Scanner::keywordType(std::string &keyword) {
-  auto it = keywords.find(keyword);
-  if (it != keywords.end()) {
-    return it->second;
+constexpr std::size_t KEYWORD_SLOTS = 64;
+constexpr std::size_t KEYWORD_MIN = 2;
+constexpr std::size_t KEYWORD_MAX = 6;
+
+// 首尾字符和长度组合成的哈希对上面的关键字恰好没有冲突，新增关键字时由下面的static_assert检查
+constexpr std::size_t keywordHash(std::string_view text) {
+  auto front = static_cast<unsigned char>(text.front());
+  auto back = static_cast<unsigned char>(text.back());
+  return (front + back + text.size() * 8) & (KEYWORD_SLOTS - 1);
+}
+
+constexpr std::array<Keyword, KEYWORD_SLOTS> makeKeywordTable() {
+  std::array<Keyword, KEYWORD_SLOTS> table{};
+  for (const Keyword &keyword : KEYWORDS) {
+    table[keywordHash(keyword.name)] = keyword;
   }
-  return std::nullopt;
+  return table;
+}
+
+constexpr std::array<Keyword, KEYWORD_SLOTS> keywordTable = makeKeywordTable();
+
+constexpr bool isPerfect() {
+  for (const Keyword &keyword : KEYWORDS) {
+    if (keyword.name.size() < KEYWORD_MIN || keyword.name.size() > KEYWORD_MAX) {
+      return false;
+    }
+    if (keywordTable[keywordHash(keyword.name)].name != keyword.name) {
+      return false;
+    }
+  }
+  return true;
+}
+
+static_assert(isPerfect(), "keyword hash collides, adjust keywordHash");
+
+} // namespace
+
+TokenType Scanner::keywordType(std::string_view text) {
+  if (text.size() < KEYWORD_MIN || text.size() > KEYWORD_MAX) {
+    return TokenType::IDENTIFIER;
+  }
+  // 空槽位的name为空，不会与长度至少为2的text相等
+  const Keyword &keyword = keywordTable[keywordHash(text)];
+  return keyword.name == text ? keyword.type : TokenType::IDENTIFIER;
 }
 
 void Scanner::reset() {
-  code = "";
+  code = {};
   tokens.clear();
   start = 0;
   current = 0;
@@ -29,14 +77,14 @@ void Scanner::reset() {
 
 char Scanner::advance() {
   current++;
-  return code.at(current - 1);
+  return code[current - 1];
 }
 
 bool Scanner::match(char c) {
   if (isAtEnd()) {
     return false;
   }
-  if (code.at(current) != c) {
+  if (code[current] != c) {
     return false;
   }
   current++;
@@ -47,20 +95,37 @@ char Scanner::peek() {
   if (isAtEnd()) {
     return '\0';
   }
-  return code.at(current);
+  return code[current];
 }
 
-char Scanner::peekPrev() { return code.at(current - 1); }
-
 char Scanner::peekNext() {
   if (current + 1 >= code.size()) {
     return '\0';
   }
-  return code.at(current + 1);
+  return code[current + 1];
 }
 
 bool Scanner::isAtEnd() { return current >= code.size(); }
 
+const char *Scanner::end() { return code.data() + code.size(); }
+
+void Scanner::skipWhitespace() {
+  if (isAtEnd() || !isWhitespace(code[current])) {
+    return;
+  }
+  // 单个空白最常见，直接跳过比调用批量查找更快；换行加缩进这样的连续空白再交给simd
+  if (current + 1 < code.size() && !isWhitespace(code[current + 1])) {
+    if (code[current] == '\n') {
+      line++;
+    }
+    current++;
+    return;
+  }
+  current = static_cast<int>(simd::skipWhitespace(code.data() + current, end(), line) - code.data());
+}
+
+bool Scanner::isWhitespace(char c) { return c == ' ' || c == '\t' || c == '\r' || c == '\n'; }
+
 bool Scanner::isDigit(char c) { return c >= '0' && c <= '9'; }
 
 bool Scanner::isAlpha(char c) { return (c >= 'a' && c <= 'z') || (c >= 'A' && c <= 'Z') || c == '_'; }
@@ -68,12 +133,7 @@ bool Scanner::isAlpha(char c) { return (c >= 'a' && c <= 'z') || (c >= 'A' && c
 bool Scanner::isAlphaNumeric(char c) { return isAlpha(c) || isDigit(c); }
 
 void Scanner::string(char c) {
-  while ((peek() != c) && !isAtEnd()) {
-    if (peek() == '\n') {
-      line++;
-    }
-    advance();
-  }
+  current = static_cast<int>(simd::find(code.data() + current, end(), c, line) - code.data());
 
   if (isAtEnd()) {
     lox::error(line, "Unterminated string.");
@@ -82,7 +142,7 @@ void Scanner::string(char c) {
 
   advance(); // 跳过闭合的引号
 
-  std::string literal = code.substr(start + 1, (current - 1) - (start + 1));
+  std::string literal(code.substr(start + 1, (current - 1) - (start + 1)));
   addToken(TokenType::STRING, literal);
 }
 
@@ -98,7 +158,12 @@ void Scanner::number() {
     }
   }
 
-  double literal = std::stod(code.substr(start, current - start));
+  double literal = 0;
+  std::from_chars_result result = std::from_chars(code.data() + start, code.data() + current, literal);
+  if (result.ec != std::errc()) {
+    lox::error(line, "Number literal out of range.");
+    return;
+  }
   addToken(TokenType::NUMBER, literal);
 }
 
@@ -106,17 +171,13 @@ void Scanner::identifier() {
   while (isAlphaNumeric(peek()) && !isAtEnd()) {
     advance();
   }
-  std::string keyword = code.substr(start, current - start);
-  std::optional<TokenType> opt = keywordType(keyword);
-  TokenType type = opt.has_value() ? opt.value() : TokenType::IDENTIFIER;
-  addToken(type);
+  addToken(keywordType(code.substr(start, current - start)));
 }
 
 void Scanner::addToken(TokenType type) { addToken(type, nullptr); }
 
-void Scanner::addToken(TokenType type, const std::any &literal) {
-  std::string lexeme = code.substr(start, current - start);
-  tokens.push_back(std::make_shared<Token>(type, lexeme, literal, line));
+void Scanner::addToken(TokenType type, const Value &literal) {
+  tokens.emplace_back(type, code.substr(start, current - start), literal, line);
 }
 
 void Scanner::scanToken() {
@@ -199,25 +260,24 @@ void Scanner::scanToken() {
     }
     case '/': {
       if (match('/')) {
-        // 行注释
-        while (peek() != '\n' && !isAtEnd()) {
-          advance();
-        }
+        // 行注释，换行留给下一次scanToken计数
+        current = static_cast<int>(simd::find(code.data() + current, end(), '\n', line) - code.data());
       } else if (match('*')) {
-        // 块注释
-        while ((peekPrev() != '*' || peek() != '/') && !isAtEnd()) {
-          if (peek() == '\n') {
-            line++;
+        // 块注释，从开头的'*'找起，"/*/"也算闭合
+        const char *p = code.data() + current - 1;
+        while (true) {
+          p = simd::find(p, end(), '*', line);
+          if (end() - p < 2) {
+            current = static_cast<int>(code.size());
+            lox::error(line, "Unclosed block comment.");
+            return;
           }
-          advance();
-        }
-
-        if (isAtEnd()) {
-          lox::error(line, "Unclosed block comment.");
-          return;
+          if (p[1] == '/') {
+            break;
+          }
+          p++;
         }
-
-        advance(); // 跳过后续的'/'
+        current = static_cast<int>(p + 2 - code.data()); // 跳过"*/"
       } else if (match('=')) {
         addToken(TokenType::SLASH_EQUAL);
       } else {
@@ -254,19 +314,23 @@ void Scanner::scanToken() {
   }
 }
 
-std::vector<SPToken> Scanner::scanTokens(const std::string &_code) {
+std::vector<Token> Scanner::scanTokens(std::string_view source) {
   reset();
 
-  code = _code;
+  code = source;
 
   while (!isAtEnd()) {
+    skipWhitespace();
+    if (isAtEnd()) {
+      break;
+    }
     start = current;
     scanToken();
   }
 
-  tokens.push_back(std::make_shared<Token>(TokenType::EOF_, "", nullptr, line));
+  tokens.emplace_back(TokenType::EOF_, "", nullptr, line);
 
-  return tokens;
+  return std::move(tokens);
 }
 
 Scanner &Scanner::getInstance() {
@@ -2,15 +2,17 @@
 #define CLOX_SCANNER_H
 
 #include "token.h"
+#include <string_view>
 #include <vector>
 
 class Scanner {
 private:
-  static std::map<std::string, TokenType> keywords;
-  static std::optional<TokenType> keywordType(std::string &keyword);
+  // 编译期生成的完美哈希表，查找不需要分配内存
+  static TokenType keywordType(std::string_view text);
 
-  std::string code;
-  std::vector<SPToken> tokens;
+  // 只引用调用方的源码，token的lexeme直接指向其中的片段
+  std::string_view code;
+  std::vector<Token> tokens;
 
   int start = 0;
   int current = 0;
@@ -20,12 +22,14 @@ private:
 
   char advance();
   char peek();
-  char peekPrev();
   char peekNext();
 
   bool isAtEnd();
+  const char *end();
+  void skipWhitespace();
   bool match(char c);
 
+  static bool isWhitespace(char c);
   static bool isDigit(char c);
   static bool isAlpha(char c);
   static bool isAlphaNumeric(char c);
@@ -35,7 +39,7 @@ private:
   void identifier();
 
   void addToken(TokenType type);
-  void addToken(TokenType type, const std::any &literal);
+  void addToken(TokenType type, const Value &literal);
 
   void scanToken();
 
@@ -46,7 +50,8 @@ public:
   Scanner(const Scanner &) = delete;
   Scanner &operator=(const Scanner &) = delete;
 
-  std::vector<SPToken> scanTokens(const std::string &_code);
+  // 返回的token引用source，调用方需要保证source在token使用期间有效
+  std::vector<Token> scanTokens(std::string_view source);
 };
 
 #endif // CLOX_SCANNER_H
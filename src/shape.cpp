@@ -0,0 +1,26 @@
+#include "shape.h"
+
+Shape *Shape::root() {
+  static Shape instance;
+  return &instance;
+}
+
+std::size_t Shape::lookUp(std::string_view name) const {
+  auto it = slots.find(std::string(name));
+  if (it != slots.end()) {
+    return it->second;
+  }
+  return NOT_FOUND;
+}
+
+Shape *Shape::transition(std::string_view name) {
+  auto it = transitions.find(std::string(name));
+  if (it != transitions.end()) {
+    return it->second.get();
+  }
+
+  std::unique_ptr<Shape> shape(new Shape());
+  shape->slots = slots;
+  shape->slots.emplace(name, slots.size());
+  return (transitions[std::string(name)] = std::move(shape)).get();
+}
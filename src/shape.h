@@ -0,0 +1,32 @@
+#ifndef CLOX_SHAPE_H
+#define CLOX_SHAPE_H
+
+#include <cstddef>
+#include <memory>
+#include <string>
+#include <string_view>
+#include <unordered_map>
+
+// 隐藏类：记录字段名到槽位的映射，按相同顺序添加字段的对象共享同一个Shape，字段值连续保存在对象自己的数组里
+// Shape从根开始按字段名转换成一棵树，创建后不再释放
+class Shape {
+private:
+  std::unordered_map<std::string, std::size_t> slots;
+  std::unordered_map<std::string, std::unique_ptr<Shape>> transitions;
+
+  Shape() = default;
+
+public:
+  static constexpr std::size_t NOT_FOUND = static_cast<std::size_t>(-1);
+
+  static Shape *root();
+  Shape(const Shape &) = delete;
+  Shape &operator=(const Shape &) = delete;
+
+  std::size_t lookUp(std::string_view name) const;
+  // 添加一个字段后的Shape，同一个Shape添加同名字段总是得到同一个结果
+  Shape *transition(std::string_view name);
+  std::size_t size() const { return slots.size(); }
+};
+
+#endif // CLOX_SHAPE_H
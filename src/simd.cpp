@@ -0,0 +1,190 @@
+#include "simd.h"
+#include <cstdint>
+
+#if defined(__GNUC__) && defined(__x86_64__)
+#define LOX_SIMD_X86
+#include <immintrin.h>
+#endif
+
+namespace {
+
+bool isWhitespace(char c) { return c == ' ' || c == '\t' || c == '\r' || c == '\n'; }
+
+const char *skipWhitespaceScalar(const char *begin, const char *end, int &lines) {
+  for (; begin < end && isWhitespace(*begin); begin++) {
+    if (*begin == '\n') {
+      lines++;
+    }
+  }
+  return begin;
+}
+
+const char *findScalar(const char *begin, const char *end, char c, int &lines) {
+  for (; begin < end && *begin != c; begin++) {
+    if (*begin == '\n') {
+      lines++;
+    }
+  }
+  return begin;
+}
+
+#ifdef LOX_SIMD_X86
+
+// stops和newlines是一个块的比较结果，每个字节一位；块内有停止位置时移动到那里并返回true，
+// 否则计入整块的换行数，由调用方前进到下一块
+inline bool settle(std::uint32_t stops, std::uint32_t newlines, const char *&begin, int &lines) {
+  if (stops == 0) {
+    lines += __builtin_popcount(newlines);
+    return false;
+  }
+  int index = __builtin_ctz(stops);
+  lines += __builtin_popcount(newlines & ((1u << index) - 1));
+  begin += index;
+  return true;
+}
+
+// SSE2是x86-64的基础指令集，不需要检测
+const char *skipWhitespaceSse2(const char *begin, const char *end, int &lines) {
+  const __m128i space = _mm_set1_epi8(' ');
+  const __m128i tab = _mm_set1_epi8('\t');
+  const __m128i cr = _mm_set1_epi8('\r');
+  const __m128i lf = _mm_set1_epi8('\n');
+  while (end - begin >= 16) {
+    __m128i chunk = _mm_loadu_si128(reinterpret_cast<const __m128i *>(begin));
+    __m128i newline = _mm_cmpeq_epi8(chunk, lf);
+    __m128i blank = _mm_or_si128(_mm_or_si128(_mm_cmpeq_epi8(chunk, space), _mm_cmpeq_epi8(chunk, tab)),
+                                 _mm_or_si128(_mm_cmpeq_epi8(chunk, cr), newline));
+    auto stops = ~static_cast<std::uint32_t>(_mm_movemask_epi8(blank)) & 0xffff;
+    if (settle(stops, _mm_movemask_epi8(newline), begin, lines)) {
+      return begin;
+    }
+    begin += 16;
+  }
+  return skipWhitespaceScalar(begin, end, lines);
+}
+
+const char *findSse2(const char *begin, const char *end, char c, int &lines) {
+  const __m128i target = _mm_set1_epi8(c);
+  const __m128i lf = _mm_set1_epi8('\n');
+  while (end - begin >= 16) {
+    __m128i chunk = _mm_loadu_si128(reinterpret_cast<const __m128i *>(begin));
+    std::uint32_t stops = _mm_movemask_epi8(_mm_cmpeq_epi8(chunk, target));
+    if (settle(stops, _mm_movemask_epi8(_mm_cmpeq_epi8(chunk, lf)), begin, lines)) {
+      return begin;
+    }
+    begin += 16;
+  }
+  return findScalar(begin, end, c, lines);
+}
+
+__attribute__((target("avx2,popcnt"))) const char *skipWhitespaceAvx2(const char *begin, const char *end, int &lines) {
+  const __m256i space = _mm256_set1_epi8(' ');
+  const __m256i tab = _mm256_set1_epi8('\t');
+  const __m256i cr = _mm256_set1_epi8('\r');
+  const __m256i lf = _mm256_set1_epi8('\n');
+  while (end - begin >= 32) {
+    __m256i chunk = _mm256_loadu_si256(reinterpret_cast<const __m256i *>(begin));
+    __m256i newline = _mm256_cmpeq_epi8(chunk, lf);
+    __m256i blank = _mm256_or_si256(_mm256_or_si256(_mm256_cmpeq_epi8(chunk, space), _mm256_cmpeq_epi8(chunk, tab)),
+                                    _mm256_or_si256(_mm256_cmpeq_epi8(chunk, cr), newline));
+    auto stops = ~static_cast<std::uint32_t>(_mm256_movemask_epi8(blank));
+    if (settle(stops, _mm256_movemask_epi8(newline), begin, lines)) {
+      return begin;
+    }
+    begin += 32;
+  }
+  return skipWhitespaceSse2(begin, end, lines);
+}
+
+__attribute__((target("avx2,popcnt"))) const char *findAvx2(const char *begin, const char *end, char c, int &lines) {
+  const __m256i target = _mm256_set1_epi8(c);
+  const __m256i lf = _mm256_set1_epi8('\n');
+  while (end - begin >= 32) {
+    __m256i chunk = _mm256_loadu_si256(reinterpret_cast<const __m256i *>(begin));
+    std::uint32_t stops = _mm256_movemask_epi8(_mm256_cmpeq_epi8(chunk, target));
+    if (settle(stops, _mm256_movemask_epi8(_mm256_cmpeq_epi8(chunk, lf)), begin, lines)) {
+      return begin;
+    }
+    begin += 32;
+  }
+  return findSse2(begin, end, c, lines);
+}
+
+#endif
+
+struct Kernels {
+  simd::Level level;
+  const char *(*skipWhitespace)(const char *begin, const char *end, int &lines);
+  const char *(*find)(const char *begin, const char *end, char c, int &lines);
+};
+
+simd::Level supported() {
+#ifdef LOX_SIMD_X86
+  __builtin_cpu_init();
+  // 支持AVX2的CPU都有POPCNT，一起检查只是为了稳妥
+  bool avx2 = __builtin_cpu_supports("avx2") && __builtin_cpu_supports("popcnt");
+  return avx2 ? simd::Level::AVX2 : simd::Level::SSE2;
+#else
+  return simd::Level::SCALAR;
+#endif
+}
+
+Kernels select(simd::Level level) {
+  static const simd::Level best = supported();
+  if (level > best) {
+    level = best;
+  }
+  switch (level) {
+#ifdef LOX_SIMD_X86
+    case simd::Level::AVX2: {
+      return {level, skipWhitespaceAvx2, findAvx2};
+    }
+    case simd::Level::SSE2: {
+      return {level, skipWhitespaceSse2, findSse2};
+    }
+#endif
+    default: {
+      return {simd::Level::SCALAR, skipWhitespaceScalar, findScalar};
+    }
+  }
+}
+
+Kernels &kernels() {
+  static Kernels instance = select(simd::Level::AVX2);
+  return instance;
+}
+
+} // namespace
+
+namespace simd {
+
+Level level() { return kernels().level; }
+
+Level setLevel(Level level) {
+  kernels() = select(level);
+  return kernels().level;
+}
+
+const char *levelName(Level level) {
+  switch (level) {
+    case Level::AVX2: {
+      return "avx2";
+    }
+    case Level::SSE2: {
+      return "sse2";
+    }
+    default: {
+      return "scalar";
+    }
+  }
+}
+
+const char *skipWhitespace(const char *begin, const char *end, int &lines) {
+  return kernels().skipWhitespace(begin, end, lines);
+}
+
+const char *find(const char *begin, const char *end, char c, int &lines) {
+  return kernels().find(begin, end, c, lines);
+}
+
+} // namespace simd
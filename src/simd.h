@@ -0,0 +1,26 @@
+#ifndef CLOX_SIMD_H
+#define CLOX_SIMD_H
+
+// 扫描器的批量字符查找，一次比较16或32个字节
+// 启动时按CPU支持的指令集选择AVX2、SSE2或逐字节的实现，三者结果完全一致
+namespace simd {
+
+enum class Level { SCALAR, SSE2, AVX2 };
+
+// 当前使用的实现
+Level level();
+
+// 切换实现，超出CPU支持的级别时退回能用的最高级别，返回实际使用的级别；供测试和基准对比
+Level setLevel(Level level);
+
+const char *levelName(Level level);
+
+// 跳过空格、制表符、回车和换行，返回第一个非空白字符的位置（或end），lines加上跳过的换行数
+const char *skipWhitespace(const char *begin, const char *end, int &lines);
+
+// 返回c第一次出现的位置（或end），lines加上它之前的换行数
+const char *find(const char *begin, const char *end, char c, int &lines);
+
+} // namespace simd
+
+#endif // CLOX_SIMD_H
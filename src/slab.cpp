@@ -0,0 +1,74 @@
+#include "slab.h"
+#include <algorithm>
+#include <new>
+
+namespace {
+
+std::vector<Slab *> &registry() {
+  // 不析构，运行时对象的分配器在退出时仍然可能被访问
+  static auto *slabs = new std::vector<Slab *>();
+  return *slabs;
+}
+
+} // namespace
+
+Slab::Slab(std::string name, std::size_t objectSize) : name(std::move(name)) {
+  constexpr std::size_t align = alignof(std::max_align_t);
+  statistics.objectSize = (std::max(objectSize, sizeof(FreeNode)) + align - 1) / align * align;
+  registry().push_back(this);
+}
+
+Slab::~Slab() {
+  std::vector<Slab *> &slabs = registry();
+  slabs.erase(std::remove(slabs.begin(), slabs.end(), this), slabs.end());
+  for (void *block : blocks) {
+    ::operator delete(block);
+  }
+}
+
+const std::vector<Slab *> &Slab::all() { return registry(); }
+
+void Slab::grow() {
+  void *block = ::operator new(BLOCK_SIZE);
+  blocks.push_back(block);
+
+  std::size_t count = BLOCK_SIZE / statistics.objectSize;
+  char *memory = static_cast<char *>(block);
+  for (std::size_t i = count; i > 0; i--) {
+    auto node = reinterpret_cast<FreeNode *>(memory + (i - 1) * statistics.objectSize);
+    node->next = freeList;
+    freeList = node;
+  }
+
+  statistics.blocks++;
+  statistics.capacity += count;
+}
+
+void *Slab::allocate(std::size_t size) {
+  // 派生类比登记的尺寸大时退回普通分配
+  if (size > statistics.objectSize) {
+    return ::operator new(size);
+  }
+
+  if (!freeList) {
+    grow();
+  }
+
+  FreeNode *node = freeList;
+  freeList = node->next;
+  statistics.live++;
+  statistics.allocations++;
+  return node;
+}
+
+void Slab::deallocate(void *pointer, std::size_t size) {
+  if (size > statistics.objectSize) {
+    ::operator delete(pointer);
+    return;
+  }
+
+  auto node = static_cast<FreeNode *>(pointer);
+  node->next = freeList;
+  freeList = node;
+  statistics.live--;
+}
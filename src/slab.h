@@ -0,0 +1,50 @@
+#ifndef CLOX_SLAB_H
+#define CLOX_SLAB_H
+
+#include <cstddef>
+#include <string>
+#include <vector>
+
+// 分配器的统计信息，供嵌入方观察运行时对象的内存使用
+struct SlabStats {
+  std::size_t objectSize = 0;  // 每个对象占用的字节数（按对齐取整）
+  std::size_t blocks = 0;      // 向系统申请的块数
+  std::size_t capacity = 0;    // 所有块能容纳的对象数
+  std::size_t live = 0;        // 正在使用的对象数
+  std::size_t allocations = 0; // 累计分配次数
+};
+
+// 固定大小对象的分配器：按块向系统申请内存，释放的对象串成空闲链表，下一次分配直接复用
+// 每种运行时对象一个分配器，相当于一个尺寸等级；块在进程结束前不会归还系统
+class Slab {
+private:
+  static constexpr std::size_t BLOCK_SIZE = 64 * 1024;
+
+  struct FreeNode {
+    FreeNode *next;
+  };
+
+  std::string name;
+  FreeNode *freeList = nullptr;
+  std::vector<void *> blocks;
+  SlabStats statistics;
+
+  void grow();
+
+public:
+  Slab(std::string name, std::size_t objectSize);
+  ~Slab();
+  Slab(const Slab &) = delete;
+  Slab &operator=(const Slab &) = delete;
+
+  // 所有创建过的分配器
+  static const std::vector<Slab *> &all();
+
+  void *allocate(std::size_t size);
+  void deallocate(void *pointer, std::size_t size);
+
+  const std::string &getName() const { return name; }
+  const SlabStats &stats() const { return statistics; }
+};
+
+#endif // CLOX_SLAB_H
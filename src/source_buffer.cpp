@@ -0,0 +1,116 @@
+#include "source_buffer.h"
+#include <utility>
+
+#if defined(__unix__) || defined(__APPLE__)
+#define LOX_SOURCE_MMAP
+#include <cerrno>
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#else
+#include <fstream>
+#include <iostream>
+#include <iterator>
+#endif
+
+namespace {
+
+#ifdef LOX_SOURCE_MMAP
+
+std::string readAll(int fd) {
+  constexpr std::size_t CHUNK = 64 * 1024;
+  std::string text;
+  std::size_t size = 0;
+  while (true) {
+    text.resize(size + CHUNK);
+    ssize_t count = ::read(fd, text.data() + size, CHUNK);
+    if (count < 0 && errno == EINTR) {
+      continue;
+    }
+    if (count <= 0) {
+      break;
+    }
+    size += count;
+  }
+  text.resize(size);
+  return text;
+}
+
+#endif
+
+} // namespace
+
+SourceBuffer::SourceBuffer(std::string text) : text(std::move(text)) {}
+
+SourceBuffer::SourceBuffer(SourceBuffer &&other) noexcept
+    : text(std::move(other.text)), mapping(std::exchange(other.mapping, nullptr)),
+      length(std::exchange(other.length, 0)) {}
+
+SourceBuffer &SourceBuffer::operator=(SourceBuffer &&other) noexcept {
+  if (this != &other) {
+    release();
+    text = std::move(other.text);
+    mapping = std::exchange(other.mapping, nullptr);
+    length = std::exchange(other.length, 0);
+  }
+  return *this;
+}
+
+SourceBuffer::~SourceBuffer() { release(); }
+
+void SourceBuffer::release() {
+#ifdef LOX_SOURCE_MMAP
+  if (mapping != nullptr) {
+    ::munmap(mapping, length);
+  }
+#endif
+  mapping = nullptr;
+  length = 0;
+}
+
+SourceBuffer SourceBuffer::fromFile(const std::string &path) {
+  SourceBuffer buffer;
+#ifdef LOX_SOURCE_MMAP
+  int fd = path == "-" ? STDIN_FILENO : ::open(path.c_str(), O_RDONLY);
+  if (fd < 0) {
+    return buffer;
+  }
+
+  // 只映射非空的普通文件，长度为0的映射会失败
+  struct stat info {};
+  if (::fstat(fd, &info) == 0 && S_ISREG(info.st_mode) && info.st_size > 0) {
+    auto size = static_cast<std::size_t>(info.st_size);
+    void *address = ::mmap(nullptr, size, PROT_READ, MAP_PRIVATE, fd, 0);
+    if (address != MAP_FAILED) {
+      ::madvise(address, size, MADV_SEQUENTIAL); // 扫描器从头到尾只读一遍
+      buffer.mapping = address;
+      buffer.length = size;
+    }
+  }
+  if (buffer.mapping == nullptr) {
+    buffer.text = readAll(fd);
+  }
+
+  if (fd != STDIN_FILENO) {
+    ::close(fd);
+  }
+#else
+  if (path == "-") {
+    buffer.text.assign(std::istreambuf_iterator<char>(std::cin), std::istreambuf_iterator<char>());
+  } else {
+    std::ifstream file(path, std::ios::binary);
+    buffer.text.assign(std::istreambuf_iterator<char>(file), std::istreambuf_iterator<char>());
+  }
+#endif
+  return buffer;
+}
+
+std::string_view SourceBuffer::view() const {
+  if (mapping != nullptr) {
+    return {static_cast<const char *>(mapping), length};
+  }
+  return text;
+}
+
+bool SourceBuffer::isMapped() const { return mapping != nullptr; }
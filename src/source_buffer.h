@@ -0,0 +1,35 @@
+#ifndef CLOX_SOURCE_BUFFER_H
+#define CLOX_SOURCE_BUFFER_H
+
+#include <cstddef>
+#include <string>
+#include <string_view>
+
+// 编译单元的源码：普通文件直接映射到内存，扫描器在映射的字节上工作，不再复制整个文件
+// 管道、终端等无法映射的输入，以及REPL输入的代码，保存在字符串中
+class SourceBuffer {
+private:
+  std::string text;
+  void *mapping = nullptr;
+  std::size_t length = 0;
+
+  void release();
+
+public:
+  SourceBuffer() = default;
+  explicit SourceBuffer(std::string text);
+  SourceBuffer(SourceBuffer &&other) noexcept;
+  SourceBuffer &operator=(SourceBuffer &&other) noexcept;
+  SourceBuffer(const SourceBuffer &) = delete;
+  SourceBuffer &operator=(const SourceBuffer &) = delete;
+  ~SourceBuffer();
+
+  // path为"-"时读取标准输入；文件无法打开时得到空的源码
+  // 映射期间文件被截断会导致访问越界的页时收到SIGBUS，脚本文件不应在运行时被改写
+  static SourceBuffer fromFile(const std::string &path);
+
+  std::string_view view() const;
+  bool isMapped() const;
+};
+
+#endif // CLOX_SOURCE_BUFFER_H
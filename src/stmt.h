@@ -11,160 +11,190 @@ enum class Modifier {
   SETTER,
 };
 
+// 创建闭包时捕获的外层变量：isLocal时取当前环境链上(depth, index)的槽位，否则取外层闭包捕获列表的第index项
+// this和super不会被重新赋值，直接复制；其他变量装箱后共享
+struct Capture {
+  bool isLocal;
+  bool copy;
+  int depth;
+  int index;
+};
+
+enum class StmtKind {
+  EXPR,
+  RETURN,
+  PRINT,
+  FUN,
+  CLASS,
+  VAR,
+  BLOCK,
+  IF,
+  WHILE,
+};
+
 class Stmt {
 public:
+  const StmtKind kind;
+
+  explicit Stmt(StmtKind kind) : kind(kind) {}
   virtual ~Stmt() = default;
 };
 
-using SPStmt = std::shared_ptr<Stmt>;
-
 class ExprStmt : public Stmt {
 public:
-  SPExpr expression;
+  Expr *expression;
 
   ~ExprStmt() override = default;
 
-  explicit ExprStmt(SPExpr expression) : expression(std::move(expression)) {}
+  explicit ExprStmt(Expr *expression) : Stmt(StmtKind::EXPR), expression(expression) {}
 };
 
 class ReturnStmt : public Stmt {
 public:
   SPToken keyword;
-  SPExpr value;
+  Expr *value;
 
   ~ReturnStmt() override = default;
 
-  explicit ReturnStmt(SPToken keyword, SPExpr value) : keyword(std::move(keyword)), value(std::move(value)) {}
+  explicit ReturnStmt(SPToken keyword, Expr *value)
+      : Stmt(StmtKind::RETURN), keyword(std::move(keyword)), value(value) {}
 };
 
 class PrintStmt : public Stmt {
 public:
-  SPExpr expression;
+  Expr *expression;
 
   ~PrintStmt() override = default;
 
-  explicit PrintStmt(SPExpr expression) : expression(std::move(expression)) {}
+  explicit PrintStmt(Expr *expression) : Stmt(StmtKind::PRINT), expression(expression) {}
 };
 
 class VarStmt : public Stmt {
 public:
   SPToken name;
-  SPExpr initializer;
+  Expr *initializer;
   Modifier modifier;
 
   ~VarStmt() override = default;
 
-  VarStmt(SPToken name, SPExpr initializer, Modifier modifier)
-      : name(std::move(name)), initializer(std::move(initializer)), modifier(modifier) {}
+  VarStmt(SPToken name, Expr *initializer, Modifier modifier)
+      : Stmt(StmtKind::VAR), name(std::move(name)), initializer(initializer), modifier(modifier) {}
 };
 
 class BlockStmt : public Stmt {
 public:
-  std::vector<SPStmt> statements;
+  std::vector<Stmt *> statements;
+  // resolver判断块中的变量不会被闭包捕获时，不为它创建环境
+  bool hasEnvironment = true;
 
   ~BlockStmt() override = default;
 
-  explicit BlockStmt(std::vector<SPStmt> statements) : statements(std::move(statements)) {}
+  explicit BlockStmt(std::vector<Stmt *> statements) : Stmt(StmtKind::BLOCK), statements(std::move(statements)) {}
 };
 
 class FunStmt : public Stmt {
 public:
   SPToken name;
   std::vector<SPToken> params;
-  std::shared_ptr<BlockStmt> body;
+  BlockStmt *body;
   Modifier modifier;
+  std::vector<Capture> captures;
 
   ~FunStmt() override = default;
 
-  explicit FunStmt(SPToken name, std::vector<SPToken> params, std::shared_ptr<BlockStmt> body, Modifier modifier)
-      : name(std::move(name)), params(std::move(params)), body(std::move(body)), modifier(modifier) {}
+  explicit FunStmt(SPToken name, std::vector<SPToken> params, BlockStmt *body, Modifier modifier)
+      : Stmt(StmtKind::FUN), name(std::move(name)), params(std::move(params)), body(body), modifier(modifier) {}
 };
 
 struct ClassAttributes {
-  std::vector<std::shared_ptr<VarStmt>> variables;
-  std::vector<std::shared_ptr<FunStmt>> methods;
+  std::vector<VarStmt *> variables;
+  std::vector<FunStmt *> methods;
 };
 
 class ClassStmt : public Stmt {
 public:
   SPToken name;
-  std::shared_ptr<VariableExpr> superclass;
+  VariableExpr *superclass;
 
   ClassAttributes instanceAttributes;
   ClassAttributes staticAttributes;
+  // 实例方法和字段初始化表达式用到的类外部的局部变量
+  std::vector<Capture> captures;
 
   ~ClassStmt() override = default;
 
-  ClassStmt(SPToken name, std::shared_ptr<VariableExpr> superclass, ClassAttributes instanceAttributes,
+  ClassStmt(SPToken name, VariableExpr *superclass, ClassAttributes instanceAttributes,
             ClassAttributes staticAttributes)
-      : name(std::move(name)), superclass(std::move(superclass)), instanceAttributes(std::move(instanceAttributes)),
-        staticAttributes(std::move(staticAttributes)) {}
+      : Stmt(StmtKind::CLASS), name(std::move(name)), superclass(superclass),
+        instanceAttributes(std::move(instanceAttributes)), staticAttributes(std::move(staticAttributes)) {}
 };
 
 class IfStmt : public Stmt {
 public:
-  SPExpr condition;
-  SPStmt thenBranch;
-  SPStmt elseBranch;
+  Expr *condition;
+  Stmt *thenBranch;
+  Stmt *elseBranch;
 
   ~IfStmt() override = default;
 
-  IfStmt(SPExpr condition, SPStmt thenBranch, SPStmt elseBranch)
-      : condition(std::move(condition)), thenBranch(std::move(thenBranch)), elseBranch(std::move(elseBranch)) {}
+  IfStmt(Expr *condition, Stmt *thenBranch, Stmt *elseBranch)
+      : Stmt(StmtKind::IF), condition(condition), thenBranch(thenBranch), elseBranch(elseBranch) {}
 };
 
 class WhileStmt : public Stmt {
 public:
-  SPExpr condition;
-  SPStmt body;
+  Expr *condition;
+  Stmt *body;
 
   ~WhileStmt() override = default;
 
-  WhileStmt(SPExpr condition, SPStmt body) : condition(std::move(condition)), body(std::move(body)) {}
+  WhileStmt(Expr *condition, Stmt *body) : Stmt(StmtKind::WHILE), condition(condition), body(body) {}
 };
 
 template <typename R> class StmtVisitor {
 protected:
-  R visitStmt(SPStmt stmt) {
-    if (auto p = std::dynamic_pointer_cast<ExprStmt>(stmt)) {
-      return visitExprStmt(p);
-    }
-    if (auto p = std::dynamic_pointer_cast<ReturnStmt>(stmt)) {
-      return visitReturnStmt(p);
-    }
-    if (auto p = std::dynamic_pointer_cast<PrintStmt>(stmt)) {
-      return visitPrintStmt(p);
-    }
-    if (auto p = std::dynamic_pointer_cast<FunStmt>(stmt)) {
-      return visitFunStmt(p);
-    }
-    if (auto p = std::dynamic_pointer_cast<ClassStmt>(stmt)) {
-      return visitClassStmt(p);
-    }
-    if (auto p = std::dynamic_pointer_cast<VarStmt>(stmt)) {
-      return visitVarStmt(p);
-    }
-    if (auto p = std::dynamic_pointer_cast<BlockStmt>(stmt)) {
-      return visitBlockStmt(p);
-    }
-    if (auto p = std::dynamic_pointer_cast<IfStmt>(stmt)) {
-      return visitIfStmt(p);
-    }
-    if (auto p = std::dynamic_pointer_cast<WhileStmt>(stmt)) {
-      return visitWhileStmt(p);
+  R visitStmt(Stmt *stmt) {
+    switch (stmt->kind) {
+      case StmtKind::EXPR: {
+        return visitExprStmt(static_cast<ExprStmt *>(stmt));
+      }
+      case StmtKind::RETURN: {
+        return visitReturnStmt(static_cast<ReturnStmt *>(stmt));
+      }
+      case StmtKind::PRINT: {
+        return visitPrintStmt(static_cast<PrintStmt *>(stmt));
+      }
+      case StmtKind::FUN: {
+        return visitFunStmt(static_cast<FunStmt *>(stmt));
+      }
+      case StmtKind::CLASS: {
+        return visitClassStmt(static_cast<ClassStmt *>(stmt));
+      }
+      case StmtKind::VAR: {
+        return visitVarStmt(static_cast<VarStmt *>(stmt));
+      }
+      case StmtKind::BLOCK: {
+        return visitBlockStmt(static_cast<BlockStmt *>(stmt));
+      }
+      case StmtKind::IF: {
+        return visitIfStmt(static_cast<IfStmt *>(stmt));
+      }
+      case StmtKind::WHILE: {
+        return visitWhileStmt(static_cast<WhileStmt *>(stmt));
+      }
     }
     throw std::runtime_error("Unexpected statement type.");
   }
 
-  virtual R visitExprStmt(std::shared_ptr<ExprStmt> stmt) = 0;
-  virtual R visitReturnStmt(std::shared_ptr<ReturnStmt> stmt) = 0;
-  virtual R visitPrintStmt(std::shared_ptr<PrintStmt> stmt) = 0;
-  virtual R visitFunStmt(std::shared_ptr<FunStmt> stmt) = 0;
-  virtual R visitClassStmt(std::shared_ptr<ClassStmt> stmt) = 0;
-  virtual R visitVarStmt(std::shared_ptr<VarStmt> stmt) = 0;
-  virtual R visitBlockStmt(std::shared_ptr<BlockStmt> stmt) = 0;
-  virtual R visitIfStmt(std::shared_ptr<IfStmt> stmt) = 0;
-  virtual R visitWhileStmt(std::shared_ptr<WhileStmt> stmt) = 0;
+  virtual R visitExprStmt(ExprStmt *stmt) = 0;
+  virtual R visitReturnStmt(ReturnStmt *stmt) = 0;
+  virtual R visitPrintStmt(PrintStmt *stmt) = 0;
+  virtual R visitFunStmt(FunStmt *stmt) = 0;
+  virtual R visitClassStmt(ClassStmt *stmt) = 0;
+  virtual R visitVarStmt(VarStmt *stmt) = 0;
+  virtual R visitBlockStmt(BlockStmt *stmt) = 0;
+  virtual R visitIfStmt(IfStmt *stmt) = 0;
+  virtual R visitWhileStmt(WhileStmt *stmt) = 0;
 };
 
 #endif // CLOX_STMT_H
@@ -1,9 +1,10 @@
 #ifndef CLOX_TOKEN_H
 #define CLOX_TOKEN_H
 
-#include <any>
-#include <map>
+#include "value.h"
+#include <memory>
 #include <string>
+#include <string_view>
 
 class Token {
 public:
@@ -69,21 +70,21 @@ public:
     EOF_,
   };
 
-  static std::map<Type, std::string> types;
-  static std::optional<std::string> typeString(Type type);
+  static std::string_view typeString(Type type);
 
   Type type;
-  std::string lexeme;
-  std::any literal;
+  std::string_view lexeme; // 指向编译单元保存的源码，解析器合成的token指向字符串常量
+  Value literal;
   int line;
 
-  Token(Type type, std::string lexeme, std::any literal, int line)
-      : type(type), lexeme(std::move(lexeme)), literal(std::move(literal)), line(line) {}
+  Token(Type type, std::string_view lexeme, Value literal, int line)
+      : type(type), lexeme(lexeme), literal(std::move(literal)), line(line) {}
 
-  std::string toString();
+  std::string toString() const;
 };
 
 using TokenType = Token::Type;
-using SPToken = std::shared_ptr<Token>;
+// token按值连续保存在编译单元中，语法树和运行时对象只保存指针，编译单元负责保证它们有效
+using SPToken = const Token *;
 
 #endif // CLOX_TOKEN_H
@@ -1,16 +1,9 @@
 #include "util.h"
-#include <fstream>
-#include <sstream>
+#include <cctype>
+#include <charconv>
 
 namespace util {
 
-std::string readFile(const std::string &path) {
-  std::ifstream file(path);
-  std::stringstream buffer;
-  buffer << file.rdbuf();
-  return buffer.str();
-}
-
 std::string trimString(std::string string) { return trimString(std::move(string), " \n\r\t"); }
 
 std::string trimString(std::string string, const std::string &trimChars) {
@@ -46,37 +39,32 @@ std::string joinString(const std::vector<std::string> &list, const std::string &
   return string;
 }
 
-std::optional<std::string> toString(const std::any &value) {
-  if (!value.has_value() || isNull(value)) {
-    return "nil";
-  }
-
-  if (isString(value)) {
-    return std::any_cast<std::string>(value);
-  }
-  if (isInt(value)) {
-    return std::to_string(std::any_cast<int>(value));
-  }
-  if (isLong(value)) {
-    return std::to_string(std::any_cast<long>(value));
-  }
-  if (isLongLong(value)) {
-    return std::to_string(std::any_cast<long long>(value));
-  }
-  if (isFloat(value)) {
-    return trimNumberString(std::to_string(std::any_cast<float>(value))); // 去除末尾的'.'或'0'
-  }
-  if (isDouble(value)) {
-    return trimNumberString(std::to_string(std::any_cast<double>(value))); // 去除末尾的'.'或'0'
-  }
-  if (isBool(value)) {
-    return std::any_cast<bool>(value) ? "true" : "false";
+std::optional<std::string> toString(const Value &value) {
+  switch (value.getType()) {
+    case Value::Type::NIL: {
+      return "nil";
+    }
+    case Value::Type::BOOL: {
+      return value.asBool() ? "true" : "false";
+    }
+    case Value::Type::NUMBER: {
+      // 与printf("%f")相同的定点格式，再去除末尾的'.'或'0'；最长的double展开后也不超过这个长度
+      char buffer[512];
+      std::to_chars_result result =
+          std::to_chars(buffer, buffer + sizeof(buffer), value.asNumber(), std::chars_format::fixed, 6);
+      return trimNumberString(std::string(buffer, result.ptr));
+    }
+    case Value::Type::OBJ: {
+      if (value.isString()) {
+        return value.asString();
+      }
+    }
   }
 
   return std::nullopt;
 }
 
-std::string toString(const std::any &value, const std::string &defaultValue) {
+std::string toString(const Value &value, const std::string &defaultValue) {
   std::optional<std::string> optString = toString(value);
 
   if (optString.has_value()) {
@@ -86,40 +74,31 @@ std::string toString(const std::any &value, const std::string &defaultValue) {
   return defaultValue;
 }
 
-std::optional<double> toNumber(const std::any &value) {
-  if (!value.has_value() || isNull(value)) {
-    return 0;
-  }
-
-  if (isString(value)) {
-    auto [ok, number] = stringToNumber(std::any_cast<std::string>(value));
-    if (ok) {
-      return number;
+std::optional<double> toNumber(const Value &value) {
+  switch (value.getType()) {
+    case Value::Type::NIL: {
+      return 0;
+    }
+    case Value::Type::BOOL: {
+      return value.asBool() ? 1 : 0;
+    }
+    case Value::Type::NUMBER: {
+      return value.asNumber();
+    }
+    case Value::Type::OBJ: {
+      if (value.isString()) {
+        auto [ok, number] = stringToNumber(value.asString());
+        if (ok) {
+          return number;
+        }
+      }
     }
-  }
-  if (isInt(value)) {
-    return std::any_cast<int>(value);
-  }
-  if (isLong(value)) {
-    return std::any_cast<long>(value);
-  }
-  if (isLongLong(value)) {
-    return std::any_cast<long long>(value);
-  }
-  if (isFloat(value)) {
-    return std::any_cast<float>(value);
-  }
-  if (isDouble(value)) {
-    return std::any_cast<double>(value);
-  }
-  if (isBool(value)) {
-    return std::any_cast<bool>(value) ? 1 : 0;
   }
 
   return std::nullopt;
 }
 
-double toNumber(const std::any &value, double defaultValue) {
+double toNumber(const Value &value, double defaultValue) {
   std::optional<double> optNumber = toNumber(value);
 
   if (optNumber.has_value()) {
@@ -129,37 +108,28 @@ double toNumber(const std::any &value, double defaultValue) {
   return defaultValue;
 }
 
-std::optional<bool> toBool(const std::any &value) {
-  if (!value.has_value() || isNull(value)) {
-    return false;
-  }
-
-  if (isString(value)) {
-    return !std::any_cast<std::string>(value).empty();
-  }
-  if (isInt(value)) {
-    return std::any_cast<int>(value) != 0;
-  }
-  if (isLong(value)) {
-    return std::any_cast<long>(value) != 0;
-  }
-  if (isLongLong(value)) {
-    return std::any_cast<long long>(value) != 0;
-  }
-  if (isFloat(value)) {
-    return std::any_cast<float>(value) != 0;
-  }
-  if (isDouble(value)) {
-    return std::any_cast<double>(value) != 0;
-  }
-  if (isBool(value)) {
-    return std::any_cast<bool>(value);
+std::optional<bool> toBool(const Value &value) {
+  switch (value.getType()) {
+    case Value::Type::NIL: {
+      return false;
+    }
+    case Value::Type::BOOL: {
+      return value.asBool();
+    }
+    case Value::Type::NUMBER: {
+      return value.asNumber() != 0;
+    }
+    case Value::Type::OBJ: {
+      if (value.isString()) {
+        return !value.asString().empty();
+      }
+    }
   }
 
   return std::nullopt;
 }
 
-bool toBool(const std::any &value, bool defaultValue) {
+bool toBool(const Value &value, bool defaultValue) {
   std::optional<bool> optBool = toBool(value);
 
   if (optBool.has_value()) {
@@ -169,110 +139,49 @@ bool toBool(const std::any &value, bool defaultValue) {
   return defaultValue;
 }
 
-bool isString(const std::any &value) {
-  auto &type = value.type();
-
-  if (type == typeid(std::string)) {
-    return true;
-  }
-
-  return false;
-}
-
-bool isInt(const std::any &value) {
-  auto &type = value.type();
-
-  if (type == typeid(int)) {
-    return true;
-  }
-
-  return false;
-}
-
-bool isLong(const std::any &value) {
-  auto &type = value.type();
-
-  if (type == typeid(long)) {
-    return true;
-  }
-
-  return false;
-}
-
-bool isLongLong(const std::any &value) {
-  auto &type = value.type();
-
-  if (type == typeid(long long)) {
-    return true;
-  }
-
-  return false;
-}
-
-bool isFloat(const std::any &value) {
-  auto &type = value.type();
-
-  if (type == typeid(float)) {
-    return true;
-  }
-
-  return false;
-}
-
-bool isDouble(const std::any &value) {
-  auto &type = value.type();
+static bool isPrimitive(const Value &value) { return value.isString() || value.isNumber() || value.isBool(); }
 
-  if (type == typeid(double)) {
-    return true;
+bool isEqual(const Value &a, const Value &b) {
+  if (isPrimitive(a) && isPrimitive(b)) {
+    return (toString(a) == toString(b)) || (toNumber(a) == toNumber(b)) || (toBool(a) == toBool(b));
   }
-
   return false;
 }
 
-bool isNumber(const std::any &value) {
-  if (isInt(value) || isDouble(value) || isLong(value) || isLongLong(value)) {
-    return true;
+std::pair<bool, double> stringToNumber(std::string_view value) {
+  // 接受的写法与std::stod一致：from_chars不处理的前导空白、正号和十六进制前缀在这里处理
+  std::size_t begin = value.find_first_not_of(" \t\n\v\f\r");
+  if (begin == std::string_view::npos) {
+    return std::make_pair(false, 0);
   }
+  value.remove_prefix(begin);
 
-  return false;
-}
-
-bool isBool(const std::any &value) {
-  auto &type = value.type();
-
-  if (type == typeid(bool)) {
-    return true;
+  bool negative = value.front() == '-';
+  if (value.front() == '+' || value.front() == '-') {
+    value.remove_prefix(1);
+    if (!value.empty() && (value.front() == '+' || value.front() == '-')) {
+      return std::make_pair(false, 0);
+    }
   }
 
-  return false;
-}
-
-bool isNull(const std::any &value) {
-  auto &type = value.type();
-
-  if (type == typeid(nullptr)) {
-    return true;
+  auto format = std::chars_format::general;
+  if (value.size() > 1 && value[0] == '0' && (value[1] == 'x' || value[1] == 'X')) {
+    value.remove_prefix(2);
+    if (value.empty() || !(std::isxdigit(static_cast<unsigned char>(value.front())) || value.front() == '.')) {
+      return std::make_pair(true, negative ? -0.0 : 0.0); // 只有"0"是合法的数字部分
+    }
+    format = std::chars_format::hex;
   }
 
-  return false;
-}
-
-bool isEqual(const std::any &a, const std::any &b) {
-  if ((isString(a) || isNumber(a) || isBool(a)) && (isString(b) || isNumber(b) || isBool(b))) {
-    return (toString(a) == toString(b)) || (toNumber(a) == toNumber(b)) || (toBool(a) == toBool(b));
+  double number = 0;
+  std::from_chars_result result = std::from_chars(value.data(), value.data() + value.size(), number, format);
+  if (result.ec == std::errc::invalid_argument && format == std::chars_format::hex) {
+    return std::make_pair(true, negative ? -0.0 : 0.0); // "0x."
   }
-  return false;
-}
-
-std::pair<bool, double> stringToNumber(const std::string &value) {
-  try {
-    double number = std::stod(value);
-    return std::make_pair(true, number);
-  } catch (const std::invalid_argument &err) {
-    return std::make_pair(false, 0);
-  } catch (const std::out_of_range &err) {
+  if (result.ec != std::errc()) {
     return std::make_pair(false, 0);
   }
+  return std::make_pair(true, negative ? -number : number);
 }
 
 } // namespace util
@@ -1,14 +1,14 @@
 #ifndef CLOX_UTIL_H
 #define CLOX_UTIL_H
 
-#include <any>
+#include "value.h"
 #include <optional>
+#include <string>
+#include <string_view>
 #include <vector>
 
 namespace util {
 
-std::string readFile(const std::string &path);
-
 std::string trimString(std::string string);
 
 std::string trimString(std::string string, const std::string &trimChars);
@@ -19,39 +19,21 @@ std::string joinString(const std::vector<std::string> &list);
 
 std::string joinString(const std::vector<std::string> &list, const std::string &delimiter);
 
-std::optional<std::string> toString(const std::any &value);
-
-std::string toString(const std::any &value, const std::string &defaultValue);
-
-std::optional<double> toNumber(const std::any &value);
-
-double toNumber(const std::any &value, double defaultValue);
-
-std::optional<bool> toBool(const std::any &value);
-
-bool toBool(const std::any &value, bool defaultValue);
-
-bool isString(const std::any &value);
-
-bool isInt(const std::any &value);
-
-bool isLong(const std::any &value);
-
-bool isLongLong(const std::any &value);
+std::optional<std::string> toString(const Value &value);
 
-bool isFloat(const std::any &value);
+std::string toString(const Value &value, const std::string &defaultValue);
 
-bool isDouble(const std::any &value);
+std::optional<double> toNumber(const Value &value);
 
-bool isNumber(const std::any &value);
+double toNumber(const Value &value, double defaultValue);
 
-bool isBool(const std::any &value);
+std::optional<bool> toBool(const Value &value);
 
-bool isNull(const std::any &value);
+bool toBool(const Value &value, bool defaultValue);
 
-bool isEqual(const std::any &a, const std::any &b);
+bool isEqual(const Value &a, const Value &b);
 
-std::pair<bool, double> stringToNumber(const std::string &value);
+std::pair<bool, double> stringToNumber(std::string_view value);
 
 } // namespace util
 
@@ -0,0 +1,332 @@
+#ifndef CLOX_VALUE_H
+#define CLOX_VALUE_H
+
+#include <cmath>
+#include <cstdint>
+#include <cstring>
+#include <limits>
+#include <string>
+#include <utility>
+
+enum class ObjType {
+  STRING,
+  FUNCTION,
+  NATIVE,
+  CLASS,
+  INSTANCE,
+  CELL,
+  ENVIRONMENT,
+
+  // 字节码虚拟机使用的对象
+  PROTO,
+  CLOSURE,
+  UPVALUE,
+  BOUND_METHOD,
+  VM_CLASS,
+  VM_INSTANCE,
+};
+
+class Obj;
+
+// 垃圾回收时遍历对象直接引用的其他对象
+class Tracer {
+public:
+  virtual ~Tracer() = default;
+  virtual void visit(Obj *obj) = 0;
+};
+
+// 所有运行时对象的基类，使用侵入式引用计数，Value中只需要保存一个裸指针
+class Obj {
+private:
+  int refCount = 0;
+
+  // 登记到Heap的对象串成双向链表，回收引用计数处理不了的环
+  friend class Heap;
+  Obj *prev = nullptr;
+  Obj *next = nullptr;
+  int gcRefs = 0;
+  std::uint8_t generation = 0;
+  bool tracked = false;
+  bool marked = false;
+
+protected:
+  // 引用计数归零时调用，环境会改为回收到空闲池
+  virtual void destroy() { delete this; }
+
+public:
+  const ObjType type;
+
+  explicit Obj(ObjType type) : type(type) {}
+  virtual ~Obj();
+
+  Obj(const Obj &) = delete;
+  Obj &operator=(const Obj &) = delete;
+
+  virtual std::string toString() = 0;
+
+  // 可能参与引用环的对象需要实现：trace报告引用的对象，clear断开这些引用
+  virtual void trace(Tracer &tracer) {}
+  virtual void clear() {}
+
+  void retain() { ++refCount; }
+  void release() {
+    if (--refCount == 0) {
+      destroy();
+    }
+  }
+};
+
+template <typename T> class Ref {
+private:
+  T *pointer = nullptr;
+
+  template <typename U> friend class Ref;
+
+public:
+  Ref() = default;
+  Ref(std::nullptr_t) {}
+  Ref(T *pointer) : pointer(pointer) {
+    if (pointer) {
+      pointer->retain();
+    }
+  }
+
+  Ref(const Ref &other) : Ref(other.pointer) {}
+  Ref(Ref &&other) noexcept : pointer(std::exchange(other.pointer, nullptr)) {}
+
+  template <typename U> Ref(const Ref<U> &other) : Ref(other.pointer) {}
+  template <typename U> Ref(Ref<U> &&other) noexcept : pointer(std::exchange(other.pointer, nullptr)) {}
+
+  ~Ref() {
+    if (pointer) {
+      pointer->release();
+    }
+  }
+
+  Ref &operator=(Ref other) noexcept {
+    std::swap(pointer, other.pointer);
+    return *this;
+  }
+
+  T *get() const { return pointer; }
+  T *operator->() const { return pointer; }
+  T &operator*() const { return *pointer; }
+  explicit operator bool() const { return pointer != nullptr; }
+
+  bool operator==(const Ref &other) const { return pointer == other.pointer; }
+  bool operator!=(const Ref &other) const { return pointer != other.pointer; }
+};
+
+template <typename T, typename... Args> Ref<T> makeRef(Args &&...args) {
+  return Ref<T>(new T(std::forward<Args>(args)...));
+}
+
+class String : public Obj {
+public:
+  std::string value;
+
+  explicit String(std::string value) : Obj(ObjType::STRING), value(std::move(value)) {}
+
+  std::string toString() override { return value; }
+};
+
+using SPString = Ref<String>;
+
+enum class ValueType : std::uint8_t {
+  NIL,
+  BOOL,
+  NUMBER,
+  OBJ,
+};
+
+// 两种Value布局共用的对象类型判断和转换
+template <typename V> class ValueOps {
+private:
+  const V &self() const { return static_cast<const V &>(*this); }
+
+public:
+  bool isObjType(ObjType objType) const { return self().isObj() && self().asObj()->type == objType; }
+  bool isString() const { return isObjType(ObjType::STRING); }
+  bool isClass() const { return isObjType(ObjType::CLASS); }
+  bool isInstance() const { return isObjType(ObjType::INSTANCE); }
+  bool isCallable() const {
+    if (!self().isObj()) {
+      return false;
+    }
+    ObjType objType = self().asObj()->type;
+    return objType == ObjType::FUNCTION || objType == ObjType::NATIVE || objType == ObjType::CLASS;
+  }
+
+  const std::string &asString() const { return static_cast<String *>(self().asObj())->value; }
+
+  // 调用前需要先通过isXXX判断类型
+  template <typename T> T *as() const { return static_cast<T *>(self().asObj()); }
+  template <typename T> Ref<T> asRef() const { return Ref<T>(static_cast<T *>(self().asObj())); }
+};
+
+// nil/bool/number直接保存在Value中，对象保存指针，避免std::any的typeid判断和堆分配
+class TaggedValue : public ValueOps<TaggedValue> {
+public:
+  using Type = ValueType;
+
+private:
+  Type type;
+  union {
+    bool boolean;
+    double number;
+    Obj *obj;
+  } payload;
+
+public:
+  TaggedValue() : type(Type::NIL), payload{} {}
+  TaggedValue(std::nullptr_t) : TaggedValue() {}
+  TaggedValue(bool boolean) : type(Type::BOOL), payload{} { payload.boolean = boolean; }
+  TaggedValue(double number) : type(Type::NUMBER), payload{} { payload.number = number; }
+  TaggedValue(int number) : TaggedValue(static_cast<double>(number)) {}
+  TaggedValue(const char *string) : TaggedValue(std::string(string)) {}
+  TaggedValue(std::string string) : TaggedValue(makeRef<String>(std::move(string))) {}
+  TaggedValue(const void *) = delete; // 防止裸指针被隐式转换为bool
+
+  template <typename T> TaggedValue(const Ref<T> &object) : TaggedValue() {
+    if (object) {
+      type = Type::OBJ;
+      payload.obj = object.get();
+      payload.obj->retain();
+    }
+  }
+
+  TaggedValue(const TaggedValue &other) : type(other.type), payload(other.payload) {
+    if (type == Type::OBJ) {
+      payload.obj->retain();
+    }
+  }
+
+  TaggedValue(TaggedValue &&other) noexcept : type(other.type), payload(other.payload) { other.type = Type::NIL; }
+
+  TaggedValue &operator=(TaggedValue other) noexcept {
+    std::swap(type, other.type);
+    std::swap(payload, other.payload);
+    return *this;
+  }
+
+  ~TaggedValue() {
+    if (type == Type::OBJ) {
+      payload.obj->release();
+    }
+  }
+
+  Type getType() const { return type; }
+
+  bool isNil() const { return type == Type::NIL; }
+  bool isBool() const { return type == Type::BOOL; }
+  bool isNumber() const { return type == Type::NUMBER; }
+  bool isObj() const { return type == Type::OBJ; }
+
+  bool asBool() const { return payload.boolean; }
+  double asNumber() const { return payload.number; }
+  Obj *asObj() const { return payload.obj; }
+};
+
+// double原样保存，其余类型塞进quiet NaN的payload中：
+// 符号位置1表示对象指针（低48位），否则低两位区分nil/false/true
+class NanBoxedValue : public ValueOps<NanBoxedValue> {
+public:
+  using Type = ValueType;
+
+private:
+  static constexpr std::uint64_t SIGN_BIT = 0x8000000000000000;
+  static constexpr std::uint64_t QNAN = 0x7ffc000000000000;
+
+  static constexpr std::uint64_t TAG_NIL = 1;
+  static constexpr std::uint64_t TAG_FALSE = 2;
+  static constexpr std::uint64_t TAG_TRUE = 3;
+
+  static constexpr std::uint64_t NIL_BITS = QNAN | TAG_NIL;
+  static constexpr std::uint64_t FALSE_BITS = QNAN | TAG_FALSE;
+  static constexpr std::uint64_t TRUE_BITS = QNAN | TAG_TRUE;
+
+  std::uint64_t bits;
+
+  static std::uint64_t numberToBits(double number) {
+    if (std::isnan(number)) {
+      number = std::numeric_limits<double>::quiet_NaN(); // 统一成标准NaN，避免和带标记的值冲突
+    }
+    std::uint64_t result;
+    std::memcpy(&result, &number, sizeof(double));
+    return result;
+  }
+
+public:
+  NanBoxedValue() : bits(NIL_BITS) {}
+  NanBoxedValue(std::nullptr_t) : NanBoxedValue() {}
+  NanBoxedValue(bool boolean) : bits(boolean ? TRUE_BITS : FALSE_BITS) {}
+  NanBoxedValue(double number) : bits(numberToBits(number)) {}
+  NanBoxedValue(int number) : NanBoxedValue(static_cast<double>(number)) {}
+  NanBoxedValue(const char *string) : NanBoxedValue(std::string(string)) {}
+  NanBoxedValue(std::string string) : NanBoxedValue(makeRef<String>(std::move(string))) {}
+  NanBoxedValue(const void *) = delete; // 防止裸指针被隐式转换为bool
+
+  template <typename T> NanBoxedValue(const Ref<T> &object) : NanBoxedValue() {
+    if (object) {
+      Obj *obj = object.get();
+      bits = SIGN_BIT | QNAN | reinterpret_cast<std::uintptr_t>(obj);
+      obj->retain();
+    }
+  }
+
+  NanBoxedValue(const NanBoxedValue &other) : bits(other.bits) {
+    if (isObj()) {
+      asObj()->retain();
+    }
+  }
+
+  NanBoxedValue(NanBoxedValue &&other) noexcept : bits(std::exchange(other.bits, NIL_BITS)) {}
+
+  NanBoxedValue &operator=(NanBoxedValue other) noexcept {
+    std::swap(bits, other.bits);
+    return *this;
+  }
+
+  ~NanBoxedValue() {
+    if (isObj()) {
+      asObj()->release();
+    }
+  }
+
+  Type getType() const {
+    if (isNumber()) {
+      return Type::NUMBER;
+    }
+    if (isObj()) {
+      return Type::OBJ;
+    }
+    return bits == NIL_BITS ? Type::NIL : Type::BOOL;
+  }
+
+  bool isNil() const { return bits == NIL_BITS; }
+  bool isBool() const { return (bits | 1) == TRUE_BITS; }
+  bool isNumber() const { return (bits & QNAN) != QNAN; }
+  bool isObj() const { return (bits & (QNAN | SIGN_BIT)) == (QNAN | SIGN_BIT); }
+
+  bool asBool() const { return bits == TRUE_BITS; }
+  double asNumber() const {
+    double number;
+    std::memcpy(&number, &bits, sizeof(double));
+    return number;
+  }
+  Obj *asObj() const { return reinterpret_cast<Obj *>(static_cast<std::uintptr_t>(bits & ~(SIGN_BIT | QNAN))); }
+};
+
+#ifdef LOX_NAN_BOXING
+using Value = NanBoxedValue;
+#else
+using Value = TaggedValue;
+#endif
+
+inline void trace(Tracer &tracer, const Value &value) {
+  if (value.isObj()) {
+    tracer.visit(value.asObj());
+  }
+}
+
+#endif // CLOX_VALUE_H
@@ -0,0 +1,557 @@
+#include "vm.h"
+#include "callable.h"
+#include "lox.h"
+#include "util.h"
+#include <cmath>
+#include <iostream>
+
+using namespace util;
+
+VM::VM() : stack(STACK_MAX), frames(FRAMES_MAX) {
+  stackTop = stack.data();
+
+  globals["clock"] = SPCallable(makeRef<Clock>());
+  globals["count"] = SPCallable(makeRef<Count>());
+}
+
+void VM::reset() {
+  while (stackTop != stack.data()) {
+    pop();
+  }
+  for (int i = 0; i < frameCount; i++) {
+    frames.at(i).closure = nullptr;
+  }
+  frameCount = 0;
+  openUpvalues.clear();
+}
+
+// 指令的token标记在指令的第一个字节上，ip已经越过了操作码
+SPToken VM::currentToken() {
+  CallFrame &frame = frames.at(frameCount - 1);
+  Chunk &chunk = frame.closure->proto->chunk;
+  return chunk.tokenAt(static_cast<int>(frame.ip - chunk.code.data()) - 1);
+}
+
+InterpretError VM::runtimeError(const std::string &message) {
+  SPToken token = currentToken();
+  if (token) {
+    return Interpreter::error(token, message);
+  }
+  lox::error(0, message);
+  return {};
+}
+
+void VM::call(const SPClosure &closure, int argCount) {
+  if (argCount != closure->proto->arity) {
+    throw runtimeError("Expected " + toString(closure->proto->arity, "") + " arguments but got " +
+                       toString(argCount, "") + ".");
+  }
+
+  if (frameCount == FRAMES_MAX) {
+    throw runtimeError("Stack overflow.");
+  }
+
+  // 参数和被调用者都在栈上，栈上的值由Ref持有，可以安全地回收
+  Heap::getInstance().collectIfNeeded();
+
+  CallFrame &frame = frames.at(frameCount++);
+  frame.closure = closure;
+  frame.ip = closure->proto->chunk.code.data();
+  frame.slots = stackTop - argCount - 1;
+}
+
+void VM::callValue(const Value &callee, int argCount) {
+  if (callee.isObj()) {
+    switch (callee.asObj()->type) {
+      case ObjType::CLOSURE: {
+        call(callee.asRef<ObjClosure>(), argCount);
+        return;
+      }
+      case ObjType::BOUND_METHOD: {
+        auto bound = callee.asRef<ObjBoundMethod>();
+        peek(argCount) = bound->receiver;
+        call(bound->method, argCount);
+        return;
+      }
+      case ObjType::VM_CLASS: {
+        instantiate(callee.asRef<ObjClass>(), argCount);
+        return;
+      }
+      case ObjType::NATIVE: {
+        auto native = callee.asRef<Callable>();
+        if (argCount != native->arity()) {
+          throw runtimeError("Expected " + toString(static_cast<int>(native->arity()), "") + " arguments but got " +
+                             toString(argCount, "") + ".");
+        }
+
+        std::vector<Value> arguments(stackTop - argCount, stackTop);
+        Value result = native->call(nullptr, arguments);
+        stackTop -= argCount + 1;
+        push(result);
+        return;
+      }
+      default: {
+      }
+    }
+  }
+
+  throw runtimeError("Can only call functions and classes.");
+}
+
+// 和解释器保持一致：先调用init，再计算实例字段的初始值
+void VM::instantiate(const SPObjClass &klass, int argCount) {
+  auto instance = makeRef<ObjInstance>(klass);
+
+  SPClosure initializer = klass->findMethod("init");
+  if (initializer) {
+    std::vector<Value> arguments(stackTop - argCount, stackTop);
+    stackTop -= argCount + 1;
+    push(instance); // 调用者的栈上临时保存实例，init可能抛出错误
+    invoke(initializer, instance, arguments);
+    pop();
+  } else {
+    if (argCount != 0) {
+      throw runtimeError("Expected 0 arguments but got " + toString(argCount, "") + ".");
+    }
+    stackTop -= argCount + 1;
+  }
+
+  if (klass->initializer) {
+    invoke(klass->initializer, instance, {});
+  }
+
+  push(instance);
+}
+
+// 在当前调用栈上同步执行一个方法（init、getter、setter），返回其结果
+Value VM::invoke(const SPClosure &closure, const Value &receiver, const std::vector<Value> &arguments) {
+  push(receiver);
+  for (auto &argument : arguments) {
+    push(argument);
+  }
+
+  int exitFrame = frameCount;
+  call(closure, static_cast<int>(arguments.size()));
+  run(exitFrame);
+
+  return pop();
+}
+
+SPUpvalue VM::captureUpvalue(Value *local) {
+  auto it = openUpvalues.end();
+  while (it != openUpvalues.begin() && (*std::prev(it))->location >= local) {
+    it--;
+    if ((*it)->location == local) {
+      return *it;
+    }
+  }
+
+  auto upvalue = makeRef<ObjUpvalue>(local);
+  openUpvalues.insert(it, upvalue);
+  return upvalue;
+}
+
+void VM::closeUpvalues(Value *last) {
+  while (!openUpvalues.empty() && openUpvalues.back()->location >= last) {
+    SPUpvalue &upvalue = openUpvalues.back();
+    upvalue->closed = *upvalue->location;
+    upvalue->location = &upvalue->closed;
+    openUpvalues.pop_back();
+  }
+}
+
+Value VM::getProperty(const Value &object, const std::string &name) {
+  if (object.isObjType(ObjType::VM_CLASS)) {
+    auto klass = object.as<ObjClass>();
+    auto it = klass->fields.find(name);
+    if (it != klass->fields.end()) {
+      return it->second;
+    }
+  } else if (object.isObjType(ObjType::VM_INSTANCE)) {
+    auto instance = object.as<ObjInstance>();
+    auto it = instance->fields.find(name);
+    if (it != instance->fields.end()) {
+      return it->second;
+    }
+
+    SPClosure method = instance->klass->findMethod(name);
+    if (method) {
+      if (method->proto->modifier == Modifier::GETTER) {
+        return invoke(method, object, {});
+      }
+      return makeRef<ObjBoundMethod>(object, method);
+    }
+  } else {
+    throw runtimeError("Only instances have properties.");
+  }
+
+  throw runtimeError("Undefined property '" + name + "' can't be get.");
+}
+
+void VM::setField(const SPObjInstance &instance, const std::string &name, const Value &value) {
+  auto it = instance->fields.find(name);
+  if (it != instance->fields.end()) {
+    // update
+    it->second = value;
+    return;
+  }
+
+  SPClosure method = instance->klass->findMethod(name);
+  if (method && method->proto->modifier == Modifier::SETTER) {
+    invoke(method, instance, {value});
+    return;
+  }
+
+  // create
+  instance->fields[name] = value;
+}
+
+void VM::run(int exitFrame) { // NOLINT(*-function-cognitive-complexity)
+  CallFrame *frame = &frames.at(frameCount - 1);
+
+  auto readByte = [&frame]() { return *frame->ip++; };
+  auto readShort = [&frame]() {
+    frame->ip += 2;
+    return static_cast<std::uint16_t>((frame->ip[-2] << 8) | frame->ip[-1]);
+  };
+  auto readConstant = [&frame, &readShort]() -> Value & {
+    return frame->closure->proto->chunk.constants.at(readShort());
+  };
+  auto readString = [&readConstant]() -> const std::string & { return readConstant().as<String>()->value; };
+
+  auto checkNumberOperands = [this]() {
+    if (!peek(0).isNumber() || !peek(1).isNumber()) {
+      throw runtimeError("Operands must be two numbers.");
+    }
+  };
+
+  while (true) {
+    auto instruction = static_cast<OpCode>(readByte());
+    switch (instruction) {
+      case OpCode::CONSTANT: {
+        push(readConstant());
+        break;
+      }
+      case OpCode::NIL: {
+        push(nullptr);
+        break;
+      }
+      case OpCode::TRUE: {
+        push(true);
+        break;
+      }
+      case OpCode::FALSE: {
+        push(false);
+        break;
+      }
+      case OpCode::POP: {
+        pop();
+        break;
+      }
+      case OpCode::GET_LOCAL: {
+        push(frame->slots[readByte()]);
+        break;
+      }
+      case OpCode::SET_LOCAL: {
+        frame->slots[readByte()] = peek(0);
+        break;
+      }
+      case OpCode::GET_UPVALUE: {
+        push(*frame->closure->upvalues.at(readByte())->location);
+        break;
+      }
+      case OpCode::SET_UPVALUE: {
+        *frame->closure->upvalues.at(readByte())->location = peek(0);
+        break;
+      }
+      case OpCode::GET_GLOBAL: {
+        const std::string &name = readString();
+        auto it = globals.find(name);
+        if (it == globals.end()) {
+          throw runtimeError("Undefined variable '" + name + "'.");
+        }
+        push(it->second);
+        break;
+      }
+      case OpCode::DEFINE_GLOBAL: {
+        globals[readString()] = pop();
+        break;
+      }
+      case OpCode::SET_GLOBAL: {
+        const std::string &name = readString();
+        auto it = globals.find(name);
+        if (it == globals.end()) {
+          throw runtimeError("Undefined variable '" + name + "'.");
+        }
+        it->second = peek(0);
+        break;
+      }
+      case OpCode::SET_UNRESOLVED: {
+        throw runtimeError("This variable can't be found.");
+      }
+      case OpCode::GET_PROPERTY: {
+        const std::string &name = readString();
+        Value object = pop();
+        push(getProperty(object, name));
+        break;
+      }
+      case OpCode::SET_PROPERTY: {
+        const std::string &name = readString();
+        bool returnOriginal = readByte();
+
+        Value value = pop();
+        Value object = pop();
+
+        // 和解释器保持一致：先读取原值，只允许给已存在的字段或方法赋值
+        Value original = getProperty(object, name);
+
+        if (object.isObjType(ObjType::VM_CLASS)) {
+          object.as<ObjClass>()->fields[name] = value;
+        } else {
+          auto instance = object.asRef<ObjInstance>();
+          if (!instance->klass->findMethod(name) && instance->fields.find(name) == instance->fields.end()) {
+            throw runtimeError("Undefined property '" + name + "' can't be assign.");
+          }
+          setField(instance, name, value);
+        }
+
+        push(returnOriginal ? std::move(original) : std::move(value));
+        break;
+      }
+      case OpCode::GET_SUPER: {
+        const std::string &name = readString();
+        auto superclass = pop().asRef<ObjClass>();
+
+        SPClosure method = superclass->findMethod(name);
+        if (!method) {
+          throw runtimeError("Undefined property '" + name + "'.");
+        }
+
+        Value receiver = pop();
+        push(makeRef<ObjBoundMethod>(receiver, method));
+        break;
+      }
+      case OpCode::EQUAL: {
+        Value right = pop();
+        Value left = pop();
+        push(isEqual(left, right));
+        break;
+      }
+      case OpCode::GREATER: {
+        checkNumberOperands();
+        double right = pop().asNumber();
+        double left = pop().asNumber();
+        push(left > right);
+        break;
+      }
+      case OpCode::GREATER_EQUAL: {
+        checkNumberOperands();
+        double right = pop().asNumber();
+        double left = pop().asNumber();
+        push(left >= right);
+        break;
+      }
+      case OpCode::LESS: {
+        checkNumberOperands();
+        double right = pop().asNumber();
+        double left = pop().asNumber();
+        push(left < right);
+        break;
+      }
+      case OpCode::LESS_EQUAL: {
+        checkNumberOperands();
+        double right = pop().asNumber();
+        double left = pop().asNumber();
+        push(left <= right);
+        break;
+      }
+      case OpCode::ADD: {
+        if (peek(0).isNumber() && peek(1).isNumber()) {
+          double right = pop().asNumber();
+          double left = pop().asNumber();
+          push(left + right);
+          break;
+        }
+        // 支持字符串拼接
+        if (peek(0).isString() && peek(1).isString()) {
+          Value right = pop();
+          Value left = pop();
+          push(left.asString() + right.asString());
+          break;
+        }
+        throw runtimeError("Operands must be two numbers or two strings.");
+      }
+      case OpCode::SUBTRACT: {
+        checkNumberOperands();
+        double right = pop().asNumber();
+        double left = pop().asNumber();
+        push(left - right);
+        break;
+      }
+      case OpCode::MULTIPLY: {
+        checkNumberOperands();
+        double right = pop().asNumber();
+        double left = pop().asNumber();
+        push(left * right);
+        break;
+      }
+      case OpCode::DIVIDE: {
+        checkNumberOperands();
+        double right = pop().asNumber();
+        double left = pop().asNumber();
+        if (right == 0) {
+          throw runtimeError("Division by zero"); // ZeroDivisionError
+        }
+        push(left / right);
+        break;
+      }
+      case OpCode::POWER: {
+        checkNumberOperands();
+        double right = pop().asNumber();
+        double left = pop().asNumber();
+        push(pow(left, right));
+        break;
+      }
+      case OpCode::NOT: {
+        push(!toBool(pop(), false));
+        break;
+      }
+      case OpCode::NEGATE: {
+        if (!peek(0).isNumber()) {
+          throw runtimeError("Operand must be a number.");
+        }
+        push(-pop().asNumber());
+        break;
+      }
+      case OpCode::POSITIVE: {
+        if (!peek(0).isNumber()) {
+          throw runtimeError("Operand must be a number.");
+        }
+        break;
+      }
+      case OpCode::PRINT: {
+        Value value = pop();
+        if (value.isObj()) {
+          std::cout << value.asObj()->toString() << std::endl;
+          break;
+        }
+        std::cout << toString(value, "") << std::endl;
+        break;
+      }
+      case OpCode::JUMP: {
+        std::uint16_t offset = readShort();
+        frame->ip += offset;
+        break;
+      }
+      case OpCode::JUMP_IF_FALSE: {
+        std::uint16_t offset = readShort();
+        if (!toBool(peek(0), false)) {
+          frame->ip += offset;
+        }
+        break;
+      }
+      case OpCode::LOOP: {
+        std::uint16_t offset = readShort();
+        frame->ip -= offset;
+        Heap::getInstance().collectIfNeeded(); // 循环的两次迭代之间
+        break;
+      }
+      case OpCode::CALL: {
+        int argCount = readByte();
+        callValue(peek(argCount), argCount);
+        frame = &frames.at(frameCount - 1);
+        break;
+      }
+      case OpCode::CLOSURE: {
+        auto proto = readConstant().asRef<ObjProto>();
+        auto closure = makeRef<ObjClosure>(proto);
+        for (auto &upvalue : closure->upvalues) {
+          bool isLocal = readByte();
+          std::uint8_t index = readByte();
+          if (isLocal) {
+            upvalue = captureUpvalue(frame->slots + index);
+          } else {
+            upvalue = frame->closure->upvalues.at(index);
+          }
+        }
+        push(closure);
+        break;
+      }
+      case OpCode::CLOSE_UPVALUE: {
+        closeUpvalues(stackTop - 1);
+        pop();
+        break;
+      }
+      case OpCode::RETURN: {
+        Value result = pop();
+        closeUpvalues(frame->slots);
+
+        while (stackTop != frame->slots) {
+          pop();
+        }
+        frame->closure = nullptr;
+        frameCount--;
+
+        if (frameCount == exitFrame) {
+          if (frameCount > 0) {
+            push(result);
+          }
+          return;
+        }
+
+        push(result);
+        frame = &frames.at(frameCount - 1);
+        break;
+      }
+      case OpCode::CLASS: {
+        push(makeRef<ObjClass>(readString()));
+        break;
+      }
+      case OpCode::INHERIT: {
+        if (!peek(0).isObjType(ObjType::VM_CLASS)) {
+          throw runtimeError("Superclass must be a class.");
+        }
+        peek(1).as<ObjClass>()->superclass = peek(0).asRef<ObjClass>();
+        break;
+      }
+      case OpCode::METHOD: {
+        const std::string &name = readString();
+        auto method = pop().asRef<ObjClosure>();
+        peek(0).as<ObjClass>()->methods[name] = method;
+        break;
+      }
+      case OpCode::FIELD_INITIALIZER: {
+        auto initializer = pop().asRef<ObjClosure>();
+        peek(0).as<ObjClass>()->initializer = initializer;
+        break;
+      }
+      case OpCode::DEFINE_FIELD: {
+        const std::string &name = readString();
+        Value value = pop();
+        auto instance = pop().asRef<ObjInstance>();
+        setField(instance, name, value);
+        break;
+      }
+      case OpCode::STATIC_FIELD: {
+        const std::string &name = readString();
+        Value value = pop();
+        peek(0).as<ObjClass>()->fields[name] = value;
+        break;
+      }
+    }
+  }
+}
+
+void VM::interpret(const SPProto &script) {
+  reset();
+
+  auto closure = makeRef<ObjClosure>(script);
+  push(closure);
+  call(closure, 0);
+  run(0);
+}
+
+VM &VM::getInstance() {
+  static VM instance;
+  return instance;
+}
@@ -0,0 +1,63 @@
+#ifndef CLOX_VM_H
+#define CLOX_VM_H
+
+#include "interpreter.h"
+#include "vm_object.h"
+#include <unordered_map>
+
+// 基于栈的字节码虚拟机，执行Compiler生成的脚本函数
+class VM {
+private:
+  struct CallFrame {
+    SPClosure closure;
+    std::uint8_t *ip;
+    Value *slots;
+  };
+
+  static constexpr int FRAMES_MAX = 1024;
+  static constexpr int STACK_MAX = FRAMES_MAX * 256;
+
+  std::vector<Value> stack;
+  Value *stackTop;
+
+  std::vector<CallFrame> frames;
+  int frameCount = 0;
+
+  std::unordered_map<std::string, Value> globals;
+
+  // 按栈地址升序排列的仍指向栈槽的upvalue
+  std::vector<SPUpvalue> openUpvalues;
+
+  void reset();
+
+  void push(Value value) { *stackTop++ = std::move(value); }
+  Value pop() { return std::move(*--stackTop); }
+  Value &peek(int distance) { return stackTop[-1 - distance]; }
+
+  SPToken currentToken();
+  InterpretError runtimeError(const std::string &message);
+
+  void call(const SPClosure &closure, int argCount);
+  void callValue(const Value &callee, int argCount);
+  void instantiate(const SPObjClass &klass, int argCount);
+  Value invoke(const SPClosure &closure, const Value &receiver, const std::vector<Value> &arguments);
+
+  SPUpvalue captureUpvalue(Value *local);
+  void closeUpvalues(Value *last);
+
+  Value getProperty(const Value &object, const std::string &name);
+  void setField(const SPObjInstance &instance, const std::string &name, const Value &value);
+
+  void run(int exitFrame);
+
+  VM();
+
+public:
+  static VM &getInstance();
+  VM(const VM &) = delete;
+  VM &operator=(const VM &) = delete;
+
+  void interpret(const SPProto &script);
+};
+
+#endif // CLOX_VM_H
@@ -0,0 +1,90 @@
+#include "vm_object.h"
+
+std::string ObjProto::toString() {
+  if (name) {
+    return "<function " + std::string(name->lexeme) + ">";
+  }
+  return "<script>";
+}
+
+std::string ObjUpvalue::toString() { return "<upvalue>"; }
+
+std::string ObjClosure::toString() { return proto->toString(); }
+
+// 原型只引用常量和内层原型，不会形成环，所以不登记也不报告
+void ObjClosure::trace(Tracer &tracer) {
+  for (auto &upvalue : upvalues) {
+    if (upvalue) {
+      tracer.visit(upvalue.get());
+    }
+  }
+}
+
+void ObjClosure::clear() { upvalues.clear(); }
+
+SPClosure ObjClass::findMethod(const std::string &_name) { // NOLINT(*-no-recursion)
+  auto it = methods.find(_name);
+  if (it != methods.end()) {
+    return it->second;
+  }
+
+  if (superclass) {
+    return superclass->findMethod(_name);
+  }
+
+  return nullptr;
+}
+
+std::string ObjClass::toString() { return "<class " + name + ">"; }
+
+void ObjClass::trace(Tracer &tracer) {
+  if (superclass) {
+    tracer.visit(superclass.get());
+  }
+  for (auto &[key, method] : methods) {
+    tracer.visit(method.get());
+  }
+  if (initializer) {
+    tracer.visit(initializer.get());
+  }
+  for (auto &[key, value] : fields) {
+    ::trace(tracer, value);
+  }
+}
+
+void ObjClass::clear() {
+  superclass = nullptr;
+  methods.clear();
+  initializer = nullptr;
+  fields.clear();
+}
+
+std::string ObjInstance::toString() { return "<instance of " + klass->name + ">"; }
+
+void ObjInstance::trace(Tracer &tracer) {
+  if (klass) {
+    tracer.visit(klass.get());
+  }
+  for (auto &[key, value] : fields) {
+    ::trace(tracer, value);
+  }
+}
+
+void ObjInstance::clear() {
+  klass = nullptr;
+  fields.clear();
+}
+
+std::string ObjBoundMethod::toString() { return method->toString(); }
+
+void ObjBoundMethod::trace(Tracer &tracer) {
+  ::trace(tracer, receiver);
+  if (method) {
+    tracer.visit(method.get());
+  }
+}
+
+void ObjBoundMethod::clear() {
+  receiver = nullptr;
+  method = nullptr;
+}
@@ -0,0 +1,120 @@
+#ifndef CLOX_VM_OBJECT_H
+#define CLOX_VM_OBJECT_H
+
+#include "chunk.h"
+#include "compilation_unit.h"
+#include "heap.h"
+#include "stmt.h"
+#include <unordered_map>
+
+class ObjProto;
+class ObjClosure;
+class ObjUpvalue;
+class ObjClass;
+class ObjInstance;
+class ObjBoundMethod;
+
+using SPProto = Ref<ObjProto>;
+using SPClosure = Ref<ObjClosure>;
+using SPUpvalue = Ref<ObjUpvalue>;
+using SPObjClass = Ref<ObjClass>;
+using SPObjInstance = Ref<ObjInstance>;
+
+// 编译后的函数，不带upvalue，运行时通过OpCode::CLOSURE生成闭包
+class ObjProto : public Obj {
+public:
+  SPToken name;
+  int arity = 0;
+  int upvalueCount = 0;
+  Modifier modifier = Modifier::NONE;
+  Chunk chunk;
+  SPCompilationUnit unit; // 保证name和chunk中记录的token有效
+
+  explicit ObjProto(SPToken name) : Obj(ObjType::PROTO), name(std::move(name)) {}
+
+  std::string toString() override;
+};
+
+class ObjUpvalue : public Obj {
+public:
+  Value *location;
+  Value closed;
+
+  explicit ObjUpvalue(Value *location) : Obj(ObjType::UPVALUE), location(location) {
+    Heap::getInstance().track(this);
+  }
+
+  std::string toString() override;
+  // 打开状态的upvalue指向栈槽，栈上的值本身就是根，只需要报告关闭后保存的值
+  void trace(Tracer &tracer) override { ::trace(tracer, closed); }
+  void clear() override { closed = nullptr; }
+};
+
+class ObjClosure : public Obj {
+public:
+  SPProto proto;
+  std::vector<SPUpvalue> upvalues;
+
+  explicit ObjClosure(SPProto proto)
+      : Obj(ObjType::CLOSURE), proto(std::move(proto)), upvalues(this->proto->upvalueCount) {
+    Heap::getInstance().track(this);
+  }
+
+  std::string toString() override;
+  void trace(Tracer &tracer) override;
+  void clear() override;
+};
+
+class ObjClass : public Obj {
+public:
+  std::string name;
+  SPObjClass superclass;
+
+  std::unordered_map<std::string, SPClosure> methods;
+  SPClosure findMethod(const std::string &_name);
+
+  // 实例字段的初始化表达式编译成的函数，在init之后以新实例为this调用
+  SPClosure initializer;
+
+  // 静态属性和静态方法
+  std::unordered_map<std::string, Value> fields;
+
+  explicit ObjClass(std::string name) : Obj(ObjType::VM_CLASS), name(std::move(name)) {
+    Heap::getInstance().track(this);
+  }
+
+  std::string toString() override;
+  void trace(Tracer &tracer) override;
+  void clear() override;
+};
+
+class ObjInstance : public Obj {
+public:
+  SPObjClass klass;
+  std::unordered_map<std::string, Value> fields;
+
+  explicit ObjInstance(SPObjClass klass) : Obj(ObjType::VM_INSTANCE), klass(std::move(klass)) {
+    Heap::getInstance().track(this);
+  }
+
+  std::string toString() override;
+  void trace(Tracer &tracer) override;
+  void clear() override;
+};
+
+class ObjBoundMethod : public Obj {
+public:
+  Value receiver;
+  SPClosure method;
+
+  ObjBoundMethod(Value receiver, SPClosure method)
+      : Obj(ObjType::BOUND_METHOD), receiver(std::move(receiver)), method(std::move(method)) {
+    Heap::getInstance().track(this);
+  }
+
+  std::string toString() override;
+  void trace(Tracer &tracer) override;
+  void clear() override;
+};
+
+#endif // CLOX_VM_OBJECT_H
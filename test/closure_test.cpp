@@ -0,0 +1,13 @@
+#include "lox.h"
+#include "test_util.h"
+#include <gtest/gtest.h>
+
+// 被闭包捕获的变量装箱，所有使用处共享同一个Cell
+TEST(closure_test, captures) {
+  const std::string expected = "3\n1\n5\n5\nxy\nxyy\n40";
+  test_util::testProgram("/closure.lox", expected, false);
+
+  lox::setEngine(lox::Engine::VM);
+  test_util::testProgram("/closure.lox", expected, false);
+  lox::setEngine(lox::Engine::TREE);
+}
@@ -0,0 +1,31 @@
+#include "lox.h"
+#include "test_util.h"
+#include <gtest/gtest.h>
+
+TEST(fields_test, program) {
+  const std::string expected = "1\n2\n3\n6\n3\n2\n5\n7\ninit\n2\n0";
+  test_util::testProgram("/fields.lox", expected, false);
+
+  lox::setEngine(lox::Engine::VM);
+  test_util::testProgram("/fields.lox", expected, false);
+  lox::setEngine(lox::Engine::TREE);
+}
+
+// 初始化表达式读取后面声明的字段（包括通过方法间接读取、读取自己）时，字段还不存在
+TEST(fields_test, later_field) {
+  const char *programs[] = {
+      "class A { a = this.b; b = 5; } A();",
+      "class B { a = this.a; } B();",
+      "class C { a = this.read(); b = 5; read() { return this.b; } } C();",
+  };
+  for (lox::Engine engine : {lox::Engine::TREE, lox::Engine::VM}) {
+    lox::setEngine(engine);
+    for (const char *program : programs) {
+      testing::internal::CaptureStderr();
+      ASSERT_ANY_THROW(lox::runCode(program)) << program;
+      std::string output = testing::internal::GetCapturedStderr();
+      ASSERT_NE(output.find("Undefined property"), std::string::npos) << program << ": " << output;
+    }
+  }
+  lox::setEngine(lox::Engine::TREE);
+}
@@ -0,0 +1,100 @@
+#include "environment.h"
+#include "heap.h"
+#include "vm_object.h"
+#include <gtest/gtest.h>
+#include <vector>
+
+TEST(heap_test, cycle) {
+  Heap &heap = Heap::getInstance();
+  std::size_t before = heap.objectCount();
+
+  {
+    SPEnvironment environment = Environment::create();
+    auto cell = makeRef<Cell>(nullptr);
+    environment->define(cell);
+    cell->value = environment;
+  }
+  ASSERT_EQ(heap.objectCount(), before + 2);
+
+  heap.collect();
+  ASSERT_EQ(heap.objectCount(), before);
+}
+
+TEST(heap_test, root) {
+  Heap &heap = Heap::getInstance();
+  std::size_t before = heap.objectCount();
+
+  SPEnvironment environment = Environment::create();
+  environment->define(makeRef<Cell>(nullptr));
+
+  heap.collect();
+  ASSERT_EQ(heap.objectCount(), before + 2);
+}
+
+TEST(heap_test, young) {
+  Heap &heap = Heap::getInstance();
+  heap.collect();
+
+  SPEnvironment environment = Environment::create();
+  {
+    auto cell = makeRef<Cell>(nullptr);
+    cell->value = makeRef<Cell>(cell);
+    environment->define(makeRef<Cell>(environment));
+  }
+  ASSERT_EQ(heap.youngCount(), 4);
+
+  // 新生代回收只处理新对象，存活的对象晋升到老年代
+  ASSERT_EQ(heap.collectYoung(), 2);
+  ASSERT_EQ(heap.youngCount(), 0);
+  ASSERT_EQ(heap.collectYoung(), 0);
+
+  ASSERT_EQ(heap.collect(), 0);
+  environment->clear();
+}
+
+TEST(heap_test, slice) {
+  Heap &heap = Heap::getInstance();
+  heap.collect();
+  std::size_t before = heap.objectCount();
+
+  SPEnvironment environment = Environment::create();
+  std::vector<Ref<Cell>> cycles;
+  for (int i = 0; i < 10; i++) {
+    auto cell = makeRef<Cell>(nullptr);
+    cell->value = makeRef<Cell>(cell);
+    cycles.push_back(cell);
+    environment->define(makeRef<Cell>(nullptr));
+  }
+  ASSERT_EQ(heap.collectYoung(), 0);
+  cycles.clear();
+
+  // 老年代分成多片处理，每片都不会切开环，一轮结束时所有环都被回收
+  heap.setSliceSize(4);
+  std::size_t garbage = 0;
+  int slices = 0;
+  do {
+    garbage += heap.collectSlice();
+    slices++;
+  } while (heap.isSweeping());
+  heap.setSliceSize(4096);
+
+  ASSERT_GT(slices, 1);
+  ASSERT_EQ(garbage, 20);
+  ASSERT_EQ(heap.objectCount(), before + 11);
+}
+
+TEST(heap_test, vm_cycle) {
+  Heap &heap = Heap::getInstance();
+  std::size_t before = heap.objectCount();
+
+  {
+    auto klass = makeRef<ObjClass>("Node");
+    auto instance = makeRef<ObjInstance>(klass);
+    instance->fields["next"] = instance;
+    klass->fields["last"] = instance;
+  }
+  ASSERT_EQ(heap.objectCount(), before + 2);
+
+  heap.collect();
+  ASSERT_EQ(heap.objectCount(), before);
+}
@@ -0,0 +1,33 @@
+#include "expr.h"
+#include "lox.h"
+#include "shape.h"
+#include "test_util.h"
+#include <gtest/gtest.h>
+
+TEST(property_cache_test, eviction) {
+  PropertyCache cache;
+  const Shape *shapes[] = {Shape::root()->transition("a"), Shape::root()->transition("b"),
+                           Shape::root()->transition("c"), Shape::root()->transition("d"),
+                           Shape::root()->transition("e")};
+  for (const Shape *shape : shapes) {
+    cache.add(shape, 1)->slot = 0;
+  }
+
+  // 第五种接收者覆盖最早的记录
+  ASSERT_EQ(cache.find(shapes[0], 1), nullptr);
+  for (std::size_t i = 1; i < 5; i++) {
+    ASSERT_NE(cache.find(shapes[i], 1), nullptr);
+  }
+
+  // Shape相同但类不同时不能命中
+  ASSERT_EQ(cache.find(shapes[4], 2), nullptr);
+}
+
+TEST(property_cache_test, program) {
+  const std::string expected = "method\nfield\n45\n499999500";
+  test_util::testProgram("/property_cache.lox", expected, false);
+
+  lox::setEngine(lox::Engine::VM);
+  test_util::testProgram("/property_cache.lox", expected, false);
+  lox::setEngine(lox::Engine::TREE);
+}
@@ -0,0 +1,21 @@
+#include "scanner.h"
+#include <gtest/gtest.h>
+
+TEST(scanner_test, keywords) {
+  std::vector<Token> tokens = Scanner::getInstance().scanTokens("class classy fo for printer print if i_ getter");
+  std::vector<TokenType> types = {TokenType::CLASS,      TokenType::IDENTIFIER, TokenType::IDENTIFIER,
+                                  TokenType::FOR,        TokenType::IDENTIFIER, TokenType::PRINT,
+                                  TokenType::IF,         TokenType::IDENTIFIER, TokenType::GETTER,
+                                  TokenType::EOF_};
+  ASSERT_EQ(tokens.size(), types.size());
+  for (std::size_t i = 0; i < types.size(); i++) {
+    ASSERT_EQ(tokens[i].type, types[i]) << tokens[i].toString();
+  }
+}
+
+TEST(scanner_test, type_string) {
+  ASSERT_EQ(Token::typeString(TokenType::GETTER), "GETTER");
+  ASSERT_EQ(Token::typeString(TokenType::LESS_EQUAL), "LESS_EQUAL");
+  ASSERT_EQ(Token::typeString(TokenType::WHILE), "WHILE");
+  ASSERT_EQ(Token::typeString(TokenType::EOF_), "EOF");
+}
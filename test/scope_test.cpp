@@ -0,0 +1,13 @@
+#include "lox.h"
+#include "test_util.h"
+#include <gtest/gtest.h>
+
+// 不创建闭包的块内联到外层环境，兄弟块复用槽位
+TEST(scope_test, inlined_blocks) {
+  const std::string expected = "first\n1\nsecond\nouter\n261\n6\nplain\ncaptured\n1";
+  test_util::testProgram("/scope.lox", expected, false);
+
+  lox::setEngine(lox::Engine::VM);
+  test_util::testProgram("/scope.lox", expected, false);
+  lox::setEngine(lox::Engine::TREE);
+}
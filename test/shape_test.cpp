@@ -0,0 +1,13 @@
+#include "shape.h"
+#include <gtest/gtest.h>
+
+TEST(shape_test, transition) {
+  Shape *xy = Shape::root()->transition("x")->transition("y");
+  ASSERT_EQ(xy, Shape::root()->transition("x")->transition("y"));
+  ASSERT_NE(xy, Shape::root()->transition("y")->transition("x"));
+
+  ASSERT_EQ(xy->size(), 2);
+  ASSERT_EQ(xy->lookUp("x"), 0);
+  ASSERT_EQ(xy->lookUp("y"), 1);
+  ASSERT_EQ(xy->lookUp("z"), Shape::NOT_FOUND);
+}
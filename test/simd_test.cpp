@@ -0,0 +1,55 @@
+#include "simd.h"
+#include <gtest/gtest.h>
+#include <random>
+#include <string>
+
+namespace {
+
+// 随机生成空白、换行、引号和'*'密集的文本，让停止位置落在块内各处以及块边界上
+std::string randomText(std::mt19937 &random, std::size_t size) {
+  const std::string alphabet = "  \t\r\n\n\"'*/ax";
+  std::uniform_int_distribution<std::size_t> pick(0, alphabet.size() - 1);
+  std::string text;
+  for (std::size_t i = 0; i < size; i++) {
+    text += alphabet[pick(random)];
+  }
+  return text;
+}
+
+} // namespace
+
+TEST(simd_test, levels_agree) {
+  std::mt19937 random(42);
+  const simd::Level original = simd::level();
+  for (int round = 0; round < 200; round++) {
+    std::string text = randomText(random, round);
+    // 长空白段和长字符串体，覆盖整块都不停止的情况
+    text.insert(text.size() / 2, std::string(round, round % 2 ? ' ' : '\n'));
+    const char *end = text.data() + text.size();
+    for (std::size_t offset = 0; offset <= text.size(); offset += 7) {
+      const char *begin = text.data() + offset;
+
+      simd::setLevel(simd::Level::SCALAR);
+      int whitespaceLines = 0;
+      const char *whitespace = simd::skipWhitespace(begin, end, whitespaceLines);
+      int quoteLines = 0;
+      const char *quote = simd::find(begin, end, '"', quoteLines);
+      int starLines = 0;
+      const char *star = simd::find(begin, end, '*', starLines);
+
+      for (simd::Level level : {simd::Level::SSE2, simd::Level::AVX2}) {
+        simd::setLevel(level);
+        int lines = 0;
+        ASSERT_EQ(simd::skipWhitespace(begin, end, lines), whitespace) << simd::levelName(level);
+        ASSERT_EQ(lines, whitespaceLines) << simd::levelName(level);
+        lines = 0;
+        ASSERT_EQ(simd::find(begin, end, '"', lines), quote) << simd::levelName(level);
+        ASSERT_EQ(lines, quoteLines) << simd::levelName(level);
+        lines = 0;
+        ASSERT_EQ(simd::find(begin, end, '*', lines), star) << simd::levelName(level);
+        ASSERT_EQ(lines, starLines) << simd::levelName(level);
+      }
+    }
+  }
+  simd::setLevel(original);
+}
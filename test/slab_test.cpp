@@ -0,0 +1,18 @@
+#include "slab.h"
+#include <gtest/gtest.h>
+
+TEST(slab_test, reuse) {
+  Slab slab("test", 24);
+  ASSERT_EQ(slab.stats().objectSize % alignof(std::max_align_t), 0);
+
+  void *first = slab.allocate(24);
+  void *second = slab.allocate(24);
+  ASSERT_NE(first, second);
+  ASSERT_EQ(slab.stats().live, 2);
+  ASSERT_EQ(slab.stats().blocks, 1);
+
+  // 释放的对象下一次分配时优先复用
+  slab.deallocate(first, 24);
+  ASSERT_EQ(slab.allocate(24), first);
+  ASSERT_EQ(slab.stats().allocations, 3);
+}
@@ -0,0 +1,64 @@
+#include "source_buffer.h"
+#include <fstream>
+#include <gtest/gtest.h>
+#include <sys/stat.h>
+#include <thread>
+#include <unistd.h>
+
+namespace {
+
+std::string writeFile(const std::string &name, const std::string &content) {
+  std::string path = testing::TempDir() + name;
+  std::ofstream file(path, std::ios::binary);
+  file << content;
+  return path;
+}
+
+} // namespace
+
+TEST(source_buffer_test, mapped) {
+  std::string path = writeFile("mapped.lox", "print 1;\n");
+  SourceBuffer buffer = SourceBuffer::fromFile(path);
+  ASSERT_TRUE(buffer.isMapped());
+  ASSERT_EQ(buffer.view(), "print 1;\n");
+
+  // 移动后映射归新的对象所有
+  SourceBuffer moved = std::move(buffer);
+  ASSERT_TRUE(moved.isMapped());
+  ASSERT_EQ(moved.view(), "print 1;\n");
+  ASSERT_FALSE(buffer.isMapped());
+  ASSERT_TRUE(buffer.view().empty());
+}
+
+TEST(source_buffer_test, empty_and_missing) {
+  SourceBuffer empty = SourceBuffer::fromFile(writeFile("empty.lox", ""));
+  ASSERT_FALSE(empty.isMapped());
+  ASSERT_TRUE(empty.view().empty());
+
+  SourceBuffer missing = SourceBuffer::fromFile(testing::TempDir() + "missing.lox");
+  ASSERT_FALSE(missing.isMapped());
+  ASSERT_TRUE(missing.view().empty());
+}
+
+// 管道无法映射，分块读入字符串；内容超过一个读取块
+TEST(source_buffer_test, pipe) {
+  std::string path = testing::TempDir() + "pipe.lox";
+  ::unlink(path.c_str());
+  ASSERT_EQ(::mkfifo(path.c_str(), 0600), 0);
+
+  std::string content;
+  for (int i = 0; i < 20000; i++) {
+    content += "print " + std::to_string(i) + ";\n";
+  }
+  std::thread writer([&path, &content]() {
+    std::ofstream file(path, std::ios::binary);
+    file << content;
+  });
+
+  SourceBuffer buffer = SourceBuffer::fromFile(path);
+  writer.join();
+  ::unlink(path.c_str());
+
+  ASSERT_FALSE(buffer.isMapped());
+  ASSERT_EQ(buffer.view(), content);
+}
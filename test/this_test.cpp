@@ -0,0 +1,13 @@
+#include "lox.h"
+#include "test_util.h"
+#include <gtest/gtest.h>
+
+// 方法调用把接收者放进调用环境，两个引擎的结果一致
+TEST(this_test, receiver) {
+  const std::string expected = "4\n2\n5\n12\n212\n61\n42";
+  test_util::testProgram("/this.lox", expected, false);
+
+  lox::setEngine(lox::Engine::VM);
+  test_util::testProgram("/this.lox", expected, false);
+  lox::setEngine(lox::Engine::TREE);
+}
@@ -0,0 +1,27 @@
+#include "util.h"
+#include <cmath>
+#include <gtest/gtest.h>
+
+// 接受的写法与std::stod一致，非数字字符串返回false而不是抛出异常
+TEST(util_test, string_to_number) {
+  ASSERT_EQ(util::stringToNumber(" 12"), std::make_pair(true, 12.0));
+  ASSERT_EQ(util::stringToNumber("+3"), std::make_pair(true, 3.0));
+  ASSERT_EQ(util::stringToNumber("--1").first, false);
+  ASSERT_EQ(util::stringToNumber("-0x1p3"), std::make_pair(true, -8.0));
+  ASSERT_EQ(util::stringToNumber("0x"), std::make_pair(true, 0.0));
+  ASSERT_EQ(util::stringToNumber("0xg"), std::make_pair(true, 0.0));
+  ASSERT_EQ(util::stringToNumber("12abc"), std::make_pair(true, 12.0));
+  ASSERT_EQ(util::stringToNumber("1e400").first, false);
+  ASSERT_EQ(util::stringToNumber("apple").first, false);
+
+  auto [ok, number] = util::stringToNumber("inf");
+  ASSERT_TRUE(ok);
+  ASSERT_TRUE(std::isinf(number) && number > 0);
+}
+
+TEST(util_test, number_to_string) {
+  ASSERT_EQ(util::toString(Value(1e20), ""), "100000000000000000000");
+  ASSERT_EQ(util::toString(Value(-2.5), ""), "-2.5");
+  ASSERT_EQ(util::toString(Value(1.0 / 3), ""), "0.333333");
+  ASSERT_EQ(util::toString(Value(-1000000.0), ""), "-1000000");
+}
@@ -0,0 +1,50 @@
+#include "util.h"
+#include "value.h"
+#include <gtest/gtest.h>
+
+TEST(value_test, primitive) {
+  ASSERT_TRUE(Value().isNil());
+  ASSERT_TRUE(Value(nullptr).isNil());
+  ASSERT_TRUE(Value(true).isBool());
+  ASSERT_TRUE(Value(1).isNumber());
+  ASSERT_TRUE(Value(1.5).isNumber());
+  ASSERT_TRUE(Value("lox").isString());
+
+  ASSERT_EQ(Value(42).asNumber(), 42);
+  ASSERT_EQ(Value("lox").asString(), "lox");
+  ASSERT_EQ(util::toString(Value(45.67), ""), "45.67");
+  ASSERT_EQ(util::toString(Value(), ""), "nil");
+}
+
+TEST(value_test, equality) {
+  ASSERT_TRUE(util::isEqual(Value(1), Value(1.0)));
+  ASSERT_TRUE(util::isEqual(Value("1"), Value(1)));
+  ASSERT_FALSE(util::isEqual(Value(), Value()));
+}
+
+TEST(value_test, ownership) {
+  Value a = "shared";
+  Value b = a;
+  a = 1;
+  ASSERT_TRUE(b.isString());
+  ASSERT_EQ(b.asString(), "shared");
+}
+
+TEST(value_test, nan_boxing) {
+  ASSERT_EQ(sizeof(NanBoxedValue), 8);
+
+  ASSERT_TRUE(NanBoxedValue().isNil());
+  ASSERT_TRUE(NanBoxedValue(false).isBool());
+  ASSERT_FALSE(NanBoxedValue(false).asBool());
+  ASSERT_TRUE(NanBoxedValue(true).asBool());
+  ASSERT_EQ(NanBoxedValue(-2.5).asNumber(), -2.5);
+
+  NanBoxedValue nan = std::nan("");
+  ASSERT_TRUE(nan.isNumber());
+  ASSERT_TRUE(std::isnan(nan.asNumber()));
+
+  NanBoxedValue string = "boxed";
+  ASSERT_EQ(string.getType(), ValueType::OBJ);
+  ASSERT_TRUE(string.isString());
+  ASSERT_EQ(string.asString(), "boxed");
+}
@@ -0,0 +1,9 @@
+#include "lox.h"
+#include "test_util.h"
+#include <gtest/gtest.h>
+
+TEST(vm_test, program) {
+  lox::setEngine(lox::Engine::VM);
+  test_util::testProgram("/vm.lox", "2\n10\n42\nO\nAB\n6765", false);
+  lox::setEngine(lox::Engine::TREE);
+}